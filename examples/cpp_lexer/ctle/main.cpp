@@ -167,7 +167,7 @@ using rule_list = ctll::list<
                lexer.log(levels::warning, "string literal contains (unescaped) newline character; "
                                           "this is allowed for gcc-2 bug compatibility only "
                                           "(maybe the final `\"' is missing?)");
-               lexer.set_state(states::BUGGY_STRING_LIT);
+               lexer.template set_state<states::BUGGY_STRING_LIT>();
            } else {
                lexer.log(levels::error, "string literal missing final `\"'");
            }
@@ -176,7 +176,7 @@ using rule_list = ctll::list<
        }>,
   rule<concat<"(?:", STRCHAR, "|", ESCAPE, ")*+", QUOTE>(),
        [](auto& lexer, auto content) {
-           lexer.set_state(state_initial);
+           lexer.template set_state<state_initial>();
            return TOK_STRING_LITERAL;
        },
        std::array{states::BUGGY_STRING_LIT}>,
@@ -218,7 +218,8 @@ using lexer_definition
   = lexer<tokens, rule_list, ctle::states<states, state_definitions>,
           extensions<logger, terminator>,
           actions<default_actions::simple_return(tokens::eof),
-                  [](auto& lexer) { throw std::runtime_error("No matching input found,"); }>>;
+                  [](auto& lexer) { throw std::runtime_error("No matching input found,"); }>,
+          const char*, dfa_matcher<>>;
 
 } // namespace definition
 
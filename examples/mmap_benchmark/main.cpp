@@ -0,0 +1,103 @@
+#include "lexer.h"
+#include "rule.h"
+#include "file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+enum class tokens
+{
+    IDENTIFIER = ctle::state_reserved,
+    NUMBER,
+    PUNCTUATOR,
+    no_match,
+    eof
+};
+
+using rule_list = ctll::list<
+  ctle::rule<"[a-zA-Z_][a-zA-Z_0-9]*+", ctle::default_actions::simple_return(tokens::IDENTIFIER)>,
+  ctle::rule<"[0-9]+", ctle::default_actions::simple_return(tokens::NUMBER)>,
+  ctle::rule<"[ \t\r\n]+">, ctle::rule<".", ctle::default_actions::simple_return(tokens::PUNCTUATOR)>>;
+
+using lexer_t = ctle::lexer<tokens, rule_list>;
+
+/**
+ * @brief drops the file from the page cache, so that the next run reads it from the disk.
+ */
+void evict(const char* path) {
+    auto fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+/**
+ * @brief maps and lexes the file once.
+ *
+ * @return double the time it took in milliseconds.
+ */
+double lex_file(const char* path, ctle::map_policy policy, size_t& count) {
+    auto start = std::chrono::steady_clock::now();
+
+    ctle::basic_file<char> input{path, policy};
+    lexer_t                lexer;
+    lexer.set_input(input);
+
+    count = 0;
+    while (true) {
+        auto [token, lexeme] = lexer.lex();
+        if (token == tokens::eof || token == tokens::no_match) break;
+        ++count;
+    }
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+int main(int argc, char const* argv[]) {
+    // handle no input file
+    if (argc < 2) {
+        std::printf("usage: %s file [runs]\n", argv[0]);
+        return 1;
+    }
+
+    const auto path = argv[1];
+    const auto runs = argc > 2 ? std::atoi(argv[2]) : 5;
+    const auto size = std::filesystem::file_size(path);
+
+    const std::pair<const char*, ctle::map_policy> policies[]{
+      {"none", {}},
+      {"populate", {true, false, false, false, false}},
+      {"sequential", {false, true, false, false, false}},
+      {"will_need", {false, false, true, false, false}},
+      {"huge_pages", {false, false, false, true, false}},
+      {"fadvise", {false, false, false, false, true}},
+      {"sequential_read", ctle::map_policy::sequential_read()},
+    };
+
+    std::printf("%-16s %12s %12s %12s %12s\n", "policy", "cold ms", "cold MB/s", "warm ms",
+                "warm MB/s");
+    for (auto& [name, policy] : policies) {
+        std::vector<double> cold, warm;
+        size_t              count = 0;
+        for (int run = 0; run < runs; ++run) {
+            evict(path);
+            cold.push_back(lex_file(path, policy, count));
+            warm.push_back(lex_file(path, policy, count));
+        }
+        // medians, the runs are noisy.
+        std::sort(cold.begin(), cold.end());
+        std::sort(warm.begin(), warm.end());
+        auto cold_ms = cold[cold.size() / 2];
+        auto warm_ms = warm[warm.size() / 2];
+
+        std::printf("%-16s %12.2f %12.1f %12.2f %12.1f (%zu tokens)\n", name, cold_ms,
+                    size / 1e3 / cold_ms, warm_ms, size / 1e3 / warm_ms, count);
+    }
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+#ifndef CTLE_ADAPTIVE_FILE
+#define CTLE_ADAPTIVE_FILE
+
+#include "file.h"
+
+#include <cerrno>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ctle {
+/**
+ * @brief Buffers of one size which are reused, so that reading many small files doesn't allocate
+ * a buffer for each of them. Synchronized, a buffer may be returned by another thread than the one
+ * which took it.
+ */
+class buffer_pool
+{
+    size_t                               m_size;
+    std::mutex                           m_mutex;
+    std::vector<std::unique_ptr<char[]>> m_free;
+
+public:
+    /**
+     * @brief Construct an empty pool.
+     *
+     * @param size the size of the buffers in bytes.
+     */
+    explicit buffer_pool(size_t size) noexcept : m_size{size} {}
+    /** @brief takes a buffer from the pool, allocates one if the pool is empty. */
+    std::unique_ptr<char[]> acquire() {
+        {
+            std::lock_guard lock{m_mutex};
+            if (!m_free.empty()) {
+                auto retval = std::move(m_free.back());
+                m_free.pop_back();
+                return retval;
+            }
+        }
+        return std::make_unique<char[]>(m_size);
+    }
+    /** @brief returns a buffer taken by acquire to the pool. */
+    void release(std::unique_ptr<char[]> buffer) noexcept {
+        // if the pool can't grow the buffer is just freed.
+        try {
+            std::lock_guard lock{m_mutex};
+            m_free.push_back(std::move(buffer));
+        } catch (...) {
+        }
+    }
+
+    size_t buffer_size() const noexcept { return m_size; }
+};
+/**
+ * @brief A file which is read into a pooled buffer if it is small and mapped (see ctle::basic_file)
+ * otherwise. Reading a small file takes one read instead of a mapping, its page faults and
+ * unmapping, which matters when lexing many small files (e.g. headers through basic_file_stack).
+ * The buffers are pooled for all threads, a file may be handed to and destroyed by another thread.
+ *
+ * @tparam CharT the character type.
+ * @tparam Threshold the largest file in bytes which is read instead of mapped.
+ */
+template<typename CharT, size_t Threshold = 64 * 1024>
+class basic_adaptive_file
+{
+    basic_file<CharT>       m_mapped;
+    std::unique_ptr<char[]> m_buffer;
+    size_t                  m_size{0};
+
+public:
+    using char_t = CharT;
+    using iterator_t = const char_t*;
+    /**
+     * @brief Construct a file, reads or maps the file, throws if cannot.
+     *
+     * @param path the path to the file.
+     * @param policy the hints given when mapping the file, if it's mapped.
+     */
+    basic_adaptive_file(const std::filesystem::path& path, map_policy policy = {});
+    /**
+     * @brief Construct an empty file object. Needs initialize to be called.
+     *
+     */
+    basic_adaptive_file() noexcept = default;
+    /**
+     * @brief Destructor, returns the buffer to the pool.
+     *
+     */
+    ~basic_adaptive_file() noexcept;
+    /**
+     * @brief initializes the object. Should mimick the constructor argument wise. The buffer of a
+     * file read before is returned to the pool.
+     *
+     * @param path the path to file.
+     * @param policy the hints given when mapping the file, if it's mapped.
+     * @return true if success, false otherwise.
+     */
+    bool initialize(const std::filesystem::path& path, map_policy policy = {}) noexcept;
+    /**
+     * @brief creates a file and initializes it.
+     *
+     * @tparam Args variadic.
+     * @param args to pass to initialize.
+     * @return std::unique_ptr<basic_adaptive_file> if success, false otherwise.
+     */
+    template<typename... Args>
+    static std::unique_ptr<basic_adaptive_file> create(Args&&... args) noexcept;
+
+    // accessors
+    const CharT* begin() const noexcept {
+        return m_buffer ? reinterpret_cast<const CharT*>(m_buffer.get()) : m_mapped.begin();
+    }
+
+    const CharT* end() const noexcept { return begin() + size(); }
+
+    size_t size() const noexcept { return m_buffer ? m_size : m_mapped.size(); }
+    /** @brief whether the file is mapped rather than read. */
+    bool mapped() const noexcept { return !m_buffer; }
+
+private:
+    /** @brief the pool shared by the files of this threshold. */
+    static buffer_pool& pool() noexcept {
+        static buffer_pool retval{Threshold};
+        return retval;
+    }
+
+    bool read_file(int fd, size_t bytes) noexcept;
+};
+
+// implementation
+
+template<typename CharT, size_t Threshold>
+basic_adaptive_file<CharT, Threshold>::basic_adaptive_file(const std::filesystem::path& path,
+                                                           map_policy                   policy) {
+    if (!initialize(path, policy)) throw std::runtime_error("File could not be read.");
+}
+
+template<typename CharT, size_t Threshold>
+basic_adaptive_file<CharT, Threshold>::~basic_adaptive_file() noexcept {
+    if (m_buffer) pool().release(std::move(m_buffer));
+}
+
+template<typename CharT, size_t Threshold>
+bool basic_adaptive_file<CharT, Threshold>::initialize(const std::filesystem::path& path,
+                                                       map_policy policy) noexcept {
+    if (m_buffer) pool().release(std::move(m_buffer));
+    m_size = 0;
+
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat status;
+    if (fstat(fd, &status)) {
+        close(fd);
+        return false;
+    }
+
+    auto bytes = static_cast<size_t>(status.st_size);
+    // the mapped file takes the descriptor over.
+    if (bytes > Threshold) return m_mapped.initialize(fd, bytes, policy);
+
+    auto retval = read_file(fd, bytes);
+    close(fd);
+    return retval;
+}
+
+template<typename CharT, size_t Threshold>
+template<typename... Args>
+std::unique_ptr<basic_adaptive_file<CharT, Threshold>>
+  basic_adaptive_file<CharT, Threshold>::create(Args&&... args) noexcept {
+    auto retval = std::make_unique<basic_adaptive_file>();
+    return (retval->initialize(std::forward<Args>(args)...)) ? std::move(retval) : nullptr;
+}
+
+template<typename CharT, size_t Threshold>
+bool basic_adaptive_file<CharT, Threshold>::read_file(int fd, size_t bytes) noexcept {
+    try {
+        m_buffer = pool().acquire();
+    } catch (...) {
+        return false;
+    }
+
+    size_t done = 0;
+    while (done < bytes) {
+        auto count = read(fd, m_buffer.get() + done, bytes - done);
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0) {
+            pool().release(std::move(m_buffer));
+            return false;
+        }
+        // the file may have shrunk since its size was read.
+        if (!count) break;
+
+        done += static_cast<size_t>(count);
+    }
+    // get size in CharT.
+    m_size = done / sizeof(CharT);
+    return true;
+}
+} // namespace ctle
+
+#endif // CTLE_ADAPTIVE_FILE
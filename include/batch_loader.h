@@ -0,0 +1,536 @@
+#ifndef CTLE_BATCH_LOADER
+#define CTLE_BATCH_LOADER
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// the headers of Linux 5.6 define the opcodes used (and IORING_FEAT_CUR_PERSONALITY with them),
+// define CTLE_NO_IO_URING to always use blocking reads.
+#if !defined(CTLE_NO_IO_URING) && __has_include(<linux/io_uring.h>) \
+  && __has_include(<sys/syscall.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(IORING_FEAT_CUR_PERSONALITY) && defined(__NR_io_uring_setup)
+#define CTLE_IO_URING 1
+#endif
+#endif
+
+namespace ctle {
+#ifdef CTLE_IO_URING
+namespace uring {
+/**
+ * @brief A minimal io_uring, set up by the system calls directly, so that no library is needed.
+ * Submissions are added by sqe and submitted by submit, completions are consumed by
+ * for_each_completion.
+ */
+class ring
+{
+    int             m_fd{-1};
+    io_uring_params m_params{};
+    void*           m_sq_ring{MAP_FAILED};
+    void*           m_cq_ring{MAP_FAILED};
+    size_t          m_sq_ring_size{0};
+    size_t          m_cq_ring_size{0};
+    io_uring_sqe*   m_sqes{static_cast<io_uring_sqe*>(MAP_FAILED)};
+    unsigned        m_tail{0};
+    unsigned        m_to_submit{0};
+
+    template<typename Ty>
+    Ty* at(void* ring, unsigned offset) const noexcept {
+        return reinterpret_cast<Ty*>(static_cast<char*>(ring) + offset);
+    }
+
+public:
+    /**
+     * @brief Construct a ring, check valid, the kernel may not support io_uring or forbid it.
+     *
+     * @param entries the number of submissions which may be queued.
+     */
+    explicit ring(unsigned entries) noexcept;
+    ring(const ring&) = delete;
+    ring& operator=(const ring&) = delete;
+    /**
+     * @brief Destructor.
+     *
+     */
+    ~ring() noexcept;
+    /** @brief whether the ring was set up. */
+    bool valid() const noexcept { return m_sqes != MAP_FAILED; }
+    /**
+     * @brief gets a zeroed submission queue entry to fill in.
+     *
+     * @return io_uring_sqe* the entry, nullptr if the queue is full.
+     */
+    io_uring_sqe* sqe() noexcept;
+    /**
+     * @brief submits the entries filled in and waits for completions.
+     *
+     * @param wait the number of completions to wait for.
+     * @return true if success, false otherwise.
+     */
+    bool submit(unsigned wait) noexcept;
+    /**
+     * @brief consumes the completions which arrived.
+     *
+     * @param function called with the user_data and the result of each completion.
+     */
+    template<typename Function>
+    void for_each_completion(Function&& function) noexcept {
+        auto head = at<unsigned>(m_cq_ring, m_params.cq_off.head);
+        auto mask = *at<unsigned>(m_cq_ring, m_params.cq_off.ring_mask);
+        auto cqes = at<io_uring_cqe>(m_cq_ring, m_params.cq_off.cqes);
+
+        auto current = *head;
+        while (current != __atomic_load_n(at<unsigned>(m_cq_ring, m_params.cq_off.tail),
+                                          __ATOMIC_ACQUIRE)) {
+            auto& cqe = cqes[current & mask];
+            function(cqe.user_data, cqe.res);
+            __atomic_store_n(head, ++current, __ATOMIC_RELEASE);
+        }
+    }
+};
+
+inline ring::ring(unsigned entries) noexcept {
+    m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &m_params));
+    if (m_fd < 0) return;
+
+    m_sq_ring_size = m_params.sq_off.array + m_params.sq_entries * sizeof(unsigned);
+    m_cq_ring_size = m_params.cq_off.cqes + m_params.cq_entries * sizeof(io_uring_cqe);
+    // both rings may be in one mapping.
+    if (m_params.features & IORING_FEAT_SINGLE_MMAP)
+        m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+
+    m_sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     m_fd, IORING_OFF_SQ_RING);
+    if (m_sq_ring == MAP_FAILED) return;
+
+    m_cq_ring = (m_params.features & IORING_FEAT_SINGLE_MMAP)
+                  ? m_sq_ring
+                  : mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+    if (m_cq_ring == MAP_FAILED) return;
+
+    auto sqes = mmap(nullptr, m_params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+    m_tail = *at<unsigned>(m_sq_ring, m_params.sq_off.tail);
+}
+
+inline ring::~ring() noexcept {
+    if (m_sqes != MAP_FAILED) munmap(m_sqes, m_params.sq_entries * sizeof(io_uring_sqe));
+    if (m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring) munmap(m_cq_ring, m_cq_ring_size);
+    if (m_sq_ring != MAP_FAILED) munmap(m_sq_ring, m_sq_ring_size);
+    if (m_fd >= 0) close(m_fd);
+}
+
+inline io_uring_sqe* ring::sqe() noexcept {
+    auto head = __atomic_load_n(at<unsigned>(m_sq_ring, m_params.sq_off.head), __ATOMIC_ACQUIRE);
+    if (m_tail - head >= m_params.sq_entries) return nullptr;
+
+    auto mask = *at<unsigned>(m_sq_ring, m_params.sq_off.ring_mask);
+    auto index = m_tail++ & mask;
+    at<unsigned>(m_sq_ring, m_params.sq_off.array)[index] = index;
+    // published to the kernel once filled in, by submit.
+    ++m_to_submit;
+    return &(m_sqes[index] = io_uring_sqe{});
+}
+
+inline bool ring::submit(unsigned wait) noexcept {
+    __atomic_store_n(at<unsigned>(m_sq_ring, m_params.sq_off.tail), m_tail, __ATOMIC_RELEASE);
+    while (true) {
+        auto submitted = syscall(__NR_io_uring_enter, m_fd, m_to_submit, wait,
+                                 wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (submitted < 0 && errno == EINTR) continue;
+        if (submitted < 0) return false;
+
+        m_to_submit -= static_cast<unsigned>(submitted);
+        return true;
+    }
+}
+} // namespace uring
+#endif
+/**
+ * @brief A file read whole by ctle::basic_batch_loader.
+ *
+ * @tparam CharT the character type.
+ */
+template<typename CharT>
+class basic_loaded_file
+{
+    size_t                  m_index;
+    int                     m_error{0};
+    std::unique_ptr<char[]> m_data;
+    size_t                  m_bytes{0};
+
+    template<typename>
+    friend class basic_batch_loader;
+
+public:
+    using char_t = CharT;
+    using iterator_t = const char_t*;
+    /**
+     * @brief Construct an empty file.
+     *
+     * @param index the index of its path in the paths given to the loader.
+     */
+    explicit basic_loaded_file(size_t index) noexcept : m_index{index} {}
+
+    // accessors
+    const CharT* begin() const noexcept { return reinterpret_cast<const CharT*>(m_data.get()); }
+
+    const CharT* end() const noexcept { return begin() + size(); }
+
+    size_t size() const noexcept { return m_bytes / sizeof(CharT); }
+    /** @brief the index of its path in the paths given to the loader. */
+    size_t index() const noexcept { return m_index; }
+    /** @brief the errno of opening or reading the file, 0 if it was read. */
+    int error() const noexcept { return m_error; }
+};
+/**
+ * @brief Loads many files (such as all sources of a project) through io_uring, which opens and
+ * reads up to a number of them at once, while those loaded already are lexed. Without io_uring
+ * (not supported or not permitted by the kernel) each file is read when it is asked for. Opening
+ * files tends to cost more than lexing them, which is what the overlap saves.
+ *
+ * @tparam CharT the character type.
+ */
+template<typename CharT>
+class basic_batch_loader
+{
+public:
+    using file_t = basic_loaded_file<CharT>;
+    /** @brief the number of files loaded at once if none is specified. */
+    static constexpr unsigned default_depth = 32;
+    /**
+     * @brief Construct a loader, starts loading the files.
+     *
+     * @param paths the files to load.
+     * @param depth the number of files loaded at once, 0 to read each file when it is asked for.
+     */
+    explicit basic_batch_loader(std::vector<std::filesystem::path> paths,
+                                unsigned                           depth = default_depth);
+    basic_batch_loader(const basic_batch_loader&) = delete;
+    basic_batch_loader& operator=(const basic_batch_loader&) = delete;
+    /**
+     * @brief Destructor, waits for the files being loaded.
+     *
+     */
+    ~basic_batch_loader() noexcept;
+    /**
+     * @brief gets the next file loaded, in the order they are loaded in (see file_t::index), waits
+     * if none is loaded yet.
+     *
+     * @return std::unique_ptr<file_t> the file, check its error, nullptr once all were returned.
+     */
+    std::unique_ptr<file_t> next();
+    /** @brief whether the files are loaded through io_uring. */
+    bool asynchronous() const noexcept;
+
+private:
+    /** @brief a file being loaded. */
+    struct slot
+    {
+        std::unique_ptr<file_t> file;
+        int                     fd{-1};
+        size_t                  capacity{0};
+    };
+
+    std::vector<std::filesystem::path> m_paths;
+    size_t                             m_submitted{0};
+    std::deque<std::unique_ptr<file_t>> m_ready;
+#ifdef CTLE_IO_URING
+    std::optional<uring::ring> m_ring;
+    std::vector<slot>          m_slots;
+    std::vector<size_t>        m_free;
+    /** @brief the slots whose next operation didn't fit the submission queue. */
+    std::vector<size_t> m_deferred;
+    /** @brief the operations queued which didn't complete yet. */
+    unsigned m_in_flight{0};
+
+    /** @brief starts loading files in the free slots and the operations deferred. */
+    void fill();
+    /** @brief fills, submits and consumes the completions, waits for some completions. */
+    void pump(unsigned wait);
+    /** @brief starts the next operation of a slot (open or read), defers it if there's no room. */
+    void start(size_t index) noexcept;
+    void complete(size_t index, int result);
+    void finish(size_t index, int error) noexcept;
+    /**
+     * @brief waits for the operations in flight, taking over the files opened and what was read.
+     *
+     * @return true if the kernel no longer uses the slots, false if it can't be waited for.
+     */
+    bool drain() noexcept;
+    /** @brief loads the files being loaded and the rest by blocking reads, without the ring. */
+    void fall_back() noexcept;
+#endif
+    /**
+     * @brief reads a file (the rest of it if it was read partly) by blocking reads.
+     *
+     * @param file the file.
+     * @param path the path to open the file by, if fd is -1.
+     * @param fd the open file or -1.
+     * @param capacity the size of the buffer, if it was allocated already.
+     */
+    static void read_file(file_t& file, const std::filesystem::path& path, int fd,
+                          size_t capacity) noexcept;
+    /** @brief allocates the buffer of a file once its size is known. */
+    static bool allocate(file_t& file, int fd, size_t& capacity) noexcept;
+};
+
+// implementation
+
+template<typename CharT>
+basic_batch_loader<CharT>::basic_batch_loader(std::vector<std::filesystem::path> paths,
+                                              unsigned                           depth)
+  : m_paths{std::move(paths)} {
+#ifdef CTLE_IO_URING
+    if (!depth) return;
+
+    m_ring.emplace(depth);
+    if (!m_ring->valid()) {
+        m_ring.reset();
+        return;
+    }
+
+    m_slots.resize(depth);
+    m_deferred.reserve(depth);
+    for (size_t i = depth; i--;) m_free.push_back(i);
+#endif
+}
+
+template<typename CharT>
+basic_batch_loader<CharT>::~basic_batch_loader() noexcept {
+#ifdef CTLE_IO_URING
+    if (!m_ring) return;
+    // the kernel may still write to the buffers, which are leaked then.
+    auto drained = drain();
+    for (auto& current : m_slots) {
+        if (current.fd >= 0) close(current.fd);
+        if (!drained && current.file) current.file->m_data.release();
+    }
+#endif
+}
+
+template<typename CharT>
+std::unique_ptr<basic_loaded_file<CharT>> basic_batch_loader<CharT>::next() {
+    while (m_ready.empty()) {
+#ifdef CTLE_IO_URING
+        if (m_ring) {
+            // nothing is being loaded, all files were returned.
+            if (m_submitted == m_paths.size() && m_free.size() == m_slots.size()) return nullptr;
+
+            pump(1);
+            continue;
+        }
+#endif
+        if (m_submitted == m_paths.size()) return nullptr;
+
+        auto file = std::make_unique<file_t>(m_submitted);
+        read_file(*file, m_paths[m_submitted++], -1, 0);
+        m_ready.push_back(std::move(file));
+    }
+
+    auto retval = std::move(m_ready.front());
+    m_ready.pop_front();
+#ifdef CTLE_IO_URING
+    // the next files are loaded while this one is lexed.
+    if (m_ring) pump(0);
+#endif
+    return retval;
+}
+
+template<typename CharT>
+bool basic_batch_loader<CharT>::asynchronous() const noexcept {
+#ifdef CTLE_IO_URING
+    return m_ring.has_value();
+#else
+    return false;
+#endif
+}
+
+#ifdef CTLE_IO_URING
+template<typename CharT>
+void basic_batch_loader<CharT>::fill() {
+    auto deferred = std::move(m_deferred);
+    m_deferred.clear();
+    m_deferred.reserve(m_slots.size());
+    for (auto index : deferred) start(index);
+
+    while (m_deferred.empty() && !m_free.empty() && m_submitted < m_paths.size()) {
+        auto index = m_free.back();
+        m_free.pop_back();
+        m_slots[index].file = std::make_unique<file_t>(m_submitted++);
+        start(index);
+    }
+}
+
+template<typename CharT>
+void basic_batch_loader<CharT>::pump(unsigned wait) {
+    fill();
+    if (!m_in_flight) return;
+    if (!m_ring->submit(wait)) return fall_back();
+
+    m_ring->for_each_completion([&](auto index, auto result) {
+        --m_in_flight;
+        complete(static_cast<size_t>(index), result);
+    });
+}
+
+template<typename CharT>
+void basic_batch_loader<CharT>::start(size_t index) noexcept {
+    auto& current = m_slots[index];
+    auto& file = *current.file;
+
+    auto sqe = m_ring->sqe();
+    // reserved for all slots, doesn't allocate.
+    if (!sqe) return m_deferred.push_back(index);
+
+    ++m_in_flight;
+    sqe->user_data = index;
+    if (current.fd < 0) {
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uintptr_t>(m_paths[file.index()].c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        return;
+    }
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = current.fd;
+    sqe->addr = reinterpret_cast<uintptr_t>(file.m_data.get() + file.m_bytes);
+    sqe->len = static_cast<uint32_t>(std::min<size_t>(current.capacity - file.m_bytes, 1u << 30));
+    sqe->off = file.m_bytes;
+}
+
+template<typename CharT>
+void basic_batch_loader<CharT>::complete(size_t index, int result) {
+    auto& current = m_slots[index];
+    auto& file = *current.file;
+    auto& path = m_paths[file.index()];
+    // the kernel may not support the opcode, reading directly tells the real error if any.
+    if (result < 0) {
+        read_file(file, path, current.fd, current.capacity);
+        return finish(index, 0);
+    }
+    // opened.
+    if (current.fd < 0) {
+        current.fd = result;
+        if (!allocate(file, current.fd, current.capacity)) return finish(index, errno);
+        if (!current.capacity) return finish(index, 0);
+
+        return start(index);
+    }
+    // read, the file may have shrunk since its size was read.
+    file.m_bytes += static_cast<size_t>(result);
+    if (!result || file.m_bytes == current.capacity) return finish(index, 0);
+
+    start(index);
+}
+
+template<typename CharT>
+void basic_batch_loader<CharT>::finish(size_t index, int error) noexcept {
+    auto& current = m_slots[index];
+    if (current.fd >= 0) close(current.fd);
+    if (error) current.file->m_error = error;
+
+    m_ready.push_back(std::move(current.file));
+    current = slot{};
+    m_free.push_back(index);
+}
+
+template<typename CharT>
+bool basic_batch_loader<CharT>::drain() noexcept {
+    while (m_in_flight) {
+        if (!m_ring->submit(1)) return false;
+
+        m_ring->for_each_completion([&](auto index, auto result) {
+            auto& current = m_slots[index];
+            --m_in_flight;
+            if (result < 0) return;
+            // an open completed, otherwise a read.
+            if (current.fd < 0)
+                current.fd = result;
+            else
+                current.file->m_bytes += static_cast<size_t>(result);
+        });
+    }
+    m_deferred.clear();
+    return true;
+}
+
+template<typename CharT>
+void basic_batch_loader<CharT>::fall_back() noexcept {
+    // buffers the kernel may still write to are leaked, the files are read into new ones.
+    if (!drain())
+        for (auto& current : m_slots)
+            if (current.file) {
+                current.file->m_data.release();
+                current.file->m_bytes = 0;
+                current.capacity = 0;
+            }
+    // the files being loaded and the rest are read by blocking reads instead.
+    for (size_t index = 0; index < m_slots.size(); ++index)
+        if (m_slots[index].file) {
+            auto& current = m_slots[index];
+            read_file(*current.file, m_paths[current.file->index()], current.fd,
+                      current.capacity);
+            finish(index, 0);
+        }
+
+    m_ring.reset();
+}
+#endif
+
+template<typename CharT>
+void basic_batch_loader<CharT>::read_file(file_t& file, const std::filesystem::path& path,
+                                          int fd, size_t capacity) noexcept {
+    auto owned = fd < 0;
+    if (owned) fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        file.m_error = errno;
+        return;
+    }
+
+    if (!file.m_data && !allocate(file, fd, capacity)) file.m_error = errno;
+
+    while (!file.m_error && file.m_bytes < capacity) {
+        auto count = pread(fd, file.m_data.get() + file.m_bytes, capacity - file.m_bytes,
+                           static_cast<off_t>(file.m_bytes));
+        if (count < 0 && errno == EINTR) continue;
+        if (count < 0) file.m_error = errno;
+        if (count <= 0) break;
+
+        file.m_bytes += static_cast<size_t>(count);
+    }
+    if (owned) close(fd);
+}
+
+template<typename CharT>
+bool basic_batch_loader<CharT>::allocate(file_t& file, int fd, size_t& capacity) noexcept {
+    struct stat status;
+    if (fstat(fd, &status)) return false;
+
+    capacity = static_cast<size_t>(status.st_size);
+    try {
+        file.m_data = std::make_unique<char[]>(capacity);
+    } catch (...) {
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
+} // namespace ctle
+
+#endif // CTLE_BATCH_LOADER
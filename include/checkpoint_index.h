@@ -0,0 +1,207 @@
+#ifndef CTLE_CHECKPOINT_INDEX
+#define CTLE_CHECKPOINT_INDEX
+
+#include "states.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ctle {
+/**
+ * @brief A position lexing can start from, the end of a token and the state after it.
+ */
+struct position_checkpoint
+{
+    uint64_t offset;
+    int64_t  state;
+};
+/**
+ * @brief An index of positions lexing can start from, one every interval characters, so that the
+ * tokens of a part of a large input (such as what a viewer shows) are lexed from the nearest
+ * position before it instead of from the beginning. The index can be saved alongside the input and
+ * loaded later, the input must not change in between (see input_size).
+ *
+ * @tparam LexerT the type of the lexer, a ctle::lexer.
+ * @tparam Last a predicate on the kind of a token, which tells which token ends the input.
+ */
+template<typename LexerT, typename Last>
+class checkpoint_index
+{
+public:
+    using token_t = decltype(std::declval<LexerT&>().lex());
+    /** @brief the interval used if none is specified, in characters. */
+    static constexpr size_t default_interval = size_t{64} << 10;
+    /**
+     * @brief Construct an empty index.
+     *
+     * @param last tells which token ends the input (such as eof or no_match).
+     * @param interval the number of characters between positions.
+     */
+    explicit checkpoint_index(Last last, size_t interval = default_interval)
+      : m_last{std::move(last)}, m_interval{std::max<size_t>(interval, 1)} {}
+    /**
+     * @brief lexes a whole input, storing a position every interval characters.
+     *
+     * @param input the input, anything set_input accepts with random access iterators.
+     */
+    template<typename InputT>
+    void build(const InputT& input);
+    /**
+     * @brief lexes the tokens overlapping a part of the input, from the nearest position before.
+     *
+     * @param input the input the index was built for.
+     * @param begin the offset of the beginning of the part.
+     * @param end the offset of the end of the part.
+     * @return std::vector<token_t> the tokens, their lexemes point into the input.
+     * @throws std::invalid_argument if the input is not of the size the index was built for.
+     */
+    template<typename InputT>
+    std::vector<token_t> tokens_in(const InputT& input, size_t begin, size_t end);
+    /**
+     * @brief writes the index in a binary format of this machine.
+     *
+     * @return true if success, false otherwise.
+     */
+    bool save(std::ostream& stream) const;
+    /**
+     * @brief reads an index written by save, checks that its positions are in order, within the
+     * input and in states of the lexer.
+     *
+     * @return true if success, false otherwise (the index is left empty then).
+     */
+    bool load(std::istream& stream);
+
+    // accessors
+    const std::vector<position_checkpoint>& checkpoints() const noexcept { return m_checkpoints; }
+
+    size_t interval() const noexcept { return m_interval; }
+    /** @brief the size of the input the index was built for, in characters. */
+    size_t input_size() const noexcept { return m_input_size; }
+
+private:
+    /** @brief the first bytes of a saved index, with the version of the format. */
+    static constexpr char m_magic[8] = {'C', 'T', 'L', 'E', 'I', 'D', 'X', '1'};
+
+    LexerT                           m_lexer;
+    Last                             m_last;
+    size_t                           m_interval;
+    size_t                           m_input_size{0};
+    std::vector<position_checkpoint> m_checkpoints;
+};
+
+// implementation
+
+template<typename LexerT, typename Last>
+template<typename InputT>
+void checkpoint_index<LexerT, Last>::build(const InputT& input) {
+    auto first = input.begin();
+    m_input_size = static_cast<size_t>(std::distance(first, input.end()));
+    m_checkpoints.assign(1, position_checkpoint{0, state_initial});
+
+    m_lexer.set_state(state_initial);
+    m_lexer.set_input(input);
+    for (size_t next = m_interval;;) {
+        if (m_last(std::get<0>(m_lexer.lex()))) break;
+
+        auto position = static_cast<size_t>(std::distance(first, m_lexer.get_input().begin));
+        if (position < next) continue;
+
+        m_checkpoints.push_back(position_checkpoint{position, m_lexer.get_state()});
+        next = position - position % m_interval + m_interval;
+    }
+}
+
+template<typename LexerT, typename Last>
+template<typename InputT>
+std::vector<typename checkpoint_index<LexerT, Last>::token_t>
+  checkpoint_index<LexerT, Last>::tokens_in(const InputT& input, size_t begin, size_t end) {
+    auto first = input.begin();
+    if (static_cast<size_t>(std::distance(first, input.end())) != m_input_size)
+        throw std::invalid_argument("The index was built for another input.");
+    // the last position at or before the beginning of the part.
+    auto from = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), begin,
+                                 [](size_t offset, const auto& checkpoint) {
+                                     return offset < checkpoint.offset;
+                                 });
+    auto start = from != m_checkpoints.begin() ? *std::prev(from)
+                                               : position_checkpoint{0, state_initial};
+
+    m_lexer.set_state(static_cast<int>(start.state));
+    m_lexer.set_input(input, first + start.offset);
+
+    std::vector<token_t> retval;
+    while (true) {
+        auto token = m_lexer.lex();
+        // the lexeme of eof and no_match is empty, the position tells where they are.
+        auto end_of = static_cast<size_t>(std::distance(first, m_lexer.get_input().begin));
+        auto offset = end_of - std::get<1>(token).size();
+        if (offset >= end) break;
+
+        auto done = m_last(std::get<0>(token));
+        if (end_of > begin || offset >= begin) retval.push_back(std::move(token));
+        if (done) break;
+    }
+    return retval;
+}
+
+template<typename LexerT, typename Last>
+bool checkpoint_index<LexerT, Last>::save(std::ostream& stream) const {
+    const uint64_t header[] = {m_interval, m_input_size, m_checkpoints.size()};
+
+    stream.write(m_magic, sizeof(m_magic));
+    stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(m_checkpoints.data()),
+                 m_checkpoints.size() * sizeof(position_checkpoint));
+    return static_cast<bool>(stream);
+}
+
+template<typename LexerT, typename Last>
+bool checkpoint_index<LexerT, Last>::load(std::istream& stream) {
+    char     magic[sizeof(m_magic)];
+    uint64_t header[3];
+
+    m_checkpoints.clear();
+    if (!stream.read(magic, sizeof(magic)) || std::memcmp(magic, m_magic, sizeof(magic))
+        || !stream.read(reinterpret_cast<char*>(header), sizeof(header)) || !header[0])
+        return false;
+    // build stores the beginning and at most a position per interval.
+    if (!header[2] || header[2] > header[1] / header[0] + 1) return false;
+
+    try {
+        m_checkpoints.resize(header[2]);
+    } catch (...) {
+        return false;
+    }
+
+    auto disordered = [](const auto& left, const auto& right) {
+        return left.offset >= right.offset;
+    };
+    auto unknown = [&](const auto& checkpoint) {
+        return checkpoint.state != static_cast<int>(checkpoint.state)
+               || !m_lexer.set_state(static_cast<int>(checkpoint.state));
+    };
+    if (!stream.read(reinterpret_cast<char*>(m_checkpoints.data()),
+                     m_checkpoints.size() * sizeof(position_checkpoint))
+        || m_checkpoints.front().offset || m_checkpoints.back().offset > header[1]
+        || std::adjacent_find(m_checkpoints.begin(), m_checkpoints.end(), disordered)
+             != m_checkpoints.end()
+        || std::any_of(m_checkpoints.begin(), m_checkpoints.end(), unknown)) {
+        m_checkpoints.clear();
+        return false;
+    }
+
+    m_interval = header[0];
+    m_input_size = header[1];
+    return true;
+}
+} // namespace ctle
+
+#endif // CTLE_CHECKPOINT_INDEX
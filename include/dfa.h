@@ -0,0 +1,598 @@
+#ifndef CTLE_DFA
+#define CTLE_DFA
+
+#include "regex_traits.h"
+
+#include <ctre.hpp>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace ctle::dfa {
+/** @brief identifier of a rule within a state, one which does not exist marks no rule. */
+using rule_id_t = uint16_t;
+/** @brief identifier of a state of the automaton. */
+using state_id_t = uint16_t;
+
+constexpr rule_id_t no_rule = std::numeric_limits<rule_id_t>::max();
+// the dead state (no rule can match anymore) and the state the automaton starts in.
+constexpr state_id_t dead_state = 0;
+constexpr state_id_t start_state = 1;
+
+/**
+ * @brief A fixed size bitset of positions (leaves of a regular expression).
+ *
+ * @tparam N the number of positions.
+ */
+template<size_t N>
+struct position_set
+{
+    static constexpr size_t size = (N + 63) / 64;
+    // raw arrays are a lot cheaper than std::array for the constexpr evaluator.
+    uint64_t words[size]{};
+
+    constexpr void insert(size_t i) noexcept { words[i / 64] |= uint64_t{1} << (i % 64); }
+
+    constexpr bool contains(size_t i) const noexcept { return (words[i / 64] >> (i % 64)) & 1; }
+
+    constexpr bool empty() const noexcept {
+        for (auto word : words)
+            if (word) return false;
+        return true;
+    }
+    /**
+     * @brief calls fn with the index of every position in this set.
+     */
+    template<typename Fn>
+    constexpr void for_each(Fn&& fn) const {
+        for (size_t i = 0; i < size; ++i)
+            for (auto word = words[i]; word; word &= word - 1)
+                fn(i * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+    }
+
+    constexpr uint64_t hash() const noexcept {
+        uint64_t retval = 14695981039346656037ull;
+        for (auto word : words) retval = (retval ^ word) * 1099511628211ull;
+        return retval;
+    }
+
+    constexpr position_set& operator|=(const position_set& other) noexcept {
+        for (size_t i = 0; i < size; ++i) words[i] |= other.words[i];
+        return *this;
+    }
+
+    constexpr position_set operator|(const position_set& other) const noexcept {
+        auto retval = *this;
+        return retval |= other;
+    }
+
+    constexpr position_set operator&(const position_set& other) const noexcept {
+        auto retval = *this;
+        for (size_t i = 0; i < size; ++i) retval.words[i] &= other.words[i];
+        return retval;
+    }
+
+    constexpr bool operator==(const position_set& other) const noexcept {
+        for (size_t i = 0; i < size; ++i)
+            if (words[i] != other.words[i]) return false;
+        return true;
+    }
+};
+/**
+ * @brief The part of the position automaton built for one subexpression.
+ */
+template<size_t N>
+struct fragment
+{
+    position_set<N> first{};
+    position_set<N> last{};
+    bool            nullable{true};
+};
+/**
+ * @brief A position (Glushkov) automaton, every leaf of every pattern is one position.
+ *
+ * @tparam N the number of positions.
+ */
+template<size_t N>
+struct nfa
+{
+    /** @brief the bytes each position accepts. */
+    byte_set symbols[N]{};
+    /** @brief the positions which can follow each position. */
+    position_set<N> follow[N]{};
+    /** @brief the rule which is matched if input ends in a position. */
+    rule_id_t accepts[N]{};
+    /** @brief positions used so far. */
+    size_t size{0};
+    /**
+     * @brief adds a position matching the same bytes as the CTRE character class.
+     */
+    template<typename CharClass>
+    constexpr fragment<N> leaf() {
+        auto position = size++;
+        symbols[position] = byte_set::of<CharClass>();
+        accepts[position] = no_rule;
+
+        fragment<N> retval{};
+        retval.first.insert(position);
+        retval.last.insert(position);
+        retval.nullable = false;
+        return retval;
+    }
+
+    constexpr fragment<N> concatenate(const fragment<N>& a, const fragment<N>& b) {
+        a.last.for_each([&](size_t position) { follow[position] |= b.first; });
+        return fragment<N>{a.nullable ? a.first | b.first : a.first,
+                           b.nullable ? a.last | b.last : b.last, a.nullable && b.nullable};
+    }
+
+    constexpr fragment<N> alternate(const fragment<N>& a, const fragment<N>& b) const {
+        return fragment<N>{a.first | b.first, a.last | b.last, a.nullable || b.nullable};
+    }
+
+    constexpr fragment<N> loop(const fragment<N>& a) {
+        a.last.for_each([&](size_t position) { follow[position] |= a.first; });
+        return a;
+    }
+};
+
+/**
+ * @brief Translation of a CTRE syntax tree into the position automaton. Every specialization
+ * provides whether it can be translated, how many positions it takes and a build function.
+ * Lazy repetitions, captures, anchors, lookaheads and backreferences cannot be translated and the
+ * rule using them has to be matched by CTRE itself.
+ *
+ * @tparam Ty the CTRE atom.
+ */
+template<typename Ty>
+struct term
+{
+    static constexpr bool   supported = is_char_class<Ty>;
+    static constexpr size_t positions = supported ? 1 : 0;
+
+    template<size_t N>
+    static constexpr fragment<N> build(nfa<N>& automaton) {
+        return automaton.template leaf<Ty>();
+    }
+};
+
+template<>
+struct term<ctre::empty>
+{
+    static constexpr bool   supported = true;
+    static constexpr size_t positions = 0;
+
+    template<size_t N>
+    static constexpr fragment<N> build(nfa<N>&) {
+        return fragment<N>{};
+    }
+};
+
+template<typename... Content>
+struct term<ctre::sequence<Content...>>
+{
+    static constexpr bool   supported = (true && ... && term<Content>::supported);
+    static constexpr size_t positions = (0 + ... + term<Content>::positions);
+
+    template<size_t N>
+    static constexpr fragment<N> build(nfa<N>& automaton) {
+        fragment<N> retval{};
+        ((retval = automaton.concatenate(retval, term<Content>::build(automaton))), ...);
+        return retval;
+    }
+};
+
+template<auto... Str>
+struct term<ctre::string<Str...>> : term<ctre::sequence<ctre::character<Str>...>>
+{};
+
+template<typename... Options>
+struct term<ctre::select<Options...>>
+{
+    static constexpr bool   supported = (true && ... && term<Options>::supported);
+    static constexpr size_t positions = (0 + ... + term<Options>::positions);
+
+    template<size_t N>
+    static constexpr fragment<N> build(nfa<N>& automaton) {
+        fragment<N> retval{};
+        retval.nullable = false;
+        ((retval = automaton.alternate(retval, term<Options>::build(automaton))), ...);
+        return retval;
+    }
+};
+
+template<typename... Content>
+struct term<ctre::optional<Content...>> : term<ctre::sequence<Content...>>
+{
+    template<size_t N>
+    static constexpr fragment<N> build(nfa<N>& automaton) {
+        auto retval = term<ctre::sequence<Content...>>::build(automaton);
+        retval.nullable = true;
+        return retval;
+    }
+};
+
+template<size_t A, size_t B, typename... Content>
+struct term<ctre::repeat<A, B, Content...>>
+{
+    using content_t = term<ctre::sequence<Content...>>;
+
+    static constexpr bool   supported = content_t::supported;
+    static constexpr size_t positions = content_t::positions * (B ? B : (A ? A : 1));
+    /**
+     * @brief x{A,} is built as A - 1 copies of x followed by x+, x{A,B} as A copies of x followed
+     * by B - A copies of x?.
+     */
+    template<size_t N>
+    static constexpr fragment<N> build(nfa<N>& automaton) {
+        fragment<N> retval{};
+        if constexpr (B == 0) {
+            for (size_t i = 1; i < A; ++i)
+                retval = automaton.concatenate(retval, content_t::build(automaton));
+
+            auto tail = automaton.loop(content_t::build(automaton));
+            tail.nullable = tail.nullable || A == 0;
+            return automaton.concatenate(retval, tail);
+        } else {
+            for (size_t i = 0; i < B; ++i) {
+                auto copy = content_t::build(automaton);
+                copy.nullable = copy.nullable || i >= A;
+                retval = automaton.concatenate(retval, copy);
+            }
+            return retval;
+        }
+    }
+};
+
+// built as a greedy one, rules where that matters are left to CTRE (see first_match_is_longest).
+template<size_t A, size_t B, typename... Content>
+struct term<ctre::possessive_repeat<A, B, Content...>> : term<ctre::repeat<A, B, Content...>>
+{};
+
+/**
+ * @brief Checks whether CTRE's match of an expression, the first one by the priority of its
+ * choices, is always the longest one the automaton finds. So it is if the next byte decides every
+ * choice (an option, repeating once more or not, ...): the alternatives can't start with the same
+ * byte, nor with one which can follow them. Otherwise, such as for a|ab or for [a-z]*+[a-z] whose
+ * possessive repetition doesn't give back the last letter, the rule is matched by CTRE.
+ *
+ * @tparam Ty the CTRE atom.
+ */
+template<typename Ty>
+struct first_match_is_longest
+{
+    /** @param follow the first set of what follows the expression in its rule. */
+    static constexpr bool value([[maybe_unused]] first_set follow) noexcept { return true; }
+};
+
+template<typename... Content>
+struct first_match_is_longest<ctre::sequence<Content...>>
+{
+    static constexpr bool value(first_set follow) noexcept {
+        if constexpr (sizeof...(Content) == 0)
+            return true;
+        else
+            return each<Content...>(follow);
+    }
+
+    template<typename Head, typename... Tail>
+    static constexpr bool each(first_set follow) noexcept {
+        if constexpr (sizeof...(Tail) == 0)
+            return first_match_is_longest<Head>::value(follow);
+        else
+            return first_match_is_longest<Head>::value(
+                     first_of<ctre::sequence<Tail...>>::value().then(follow))
+                   && each<Tail...>(follow);
+    }
+};
+
+template<typename... Options>
+struct first_match_is_longest<ctre::select<Options...>>
+{
+    static constexpr bool value(first_set follow) noexcept {
+        const first_set options[]{first_of<Options>::value()...};
+
+        byte_set seen{};
+        bool     nullable = false;
+        for (const auto& option : options) {
+            // an option which can match nothing is taken before the ones after it.
+            if (nullable || option.bytes.intersects(seen)) return false;
+            seen |= option.bytes;
+            nullable = option.nullable;
+        }
+        // matching nothing competes with what follows.
+        if (nullable && seen.intersects(follow.bytes)) return false;
+        return (true && ... && first_match_is_longest<Options>::value(follow));
+    }
+};
+
+template<typename... Content>
+struct first_match_is_longest<ctre::optional<Content...>>
+{
+    static constexpr bool value(first_set follow) noexcept {
+        auto content = first_of<ctre::sequence<Content...>>::value();
+        return !content.bytes.intersects(follow.bytes)
+               && first_match_is_longest<ctre::sequence<Content...>>::value(follow);
+    }
+};
+
+template<size_t A, size_t B, typename... Content>
+struct first_match_is_longest<ctre::repeat<A, B, Content...>>
+{
+    static constexpr bool value(first_set follow) noexcept {
+        auto content = first_of<ctre::sequence<Content...>>::value();
+        // repeating once more competes with what follows.
+        if (content.nullable || content.bytes.intersects(follow.bytes)) return false;
+
+        auto after = follow;
+        after.bytes |= content.bytes;
+        return first_match_is_longest<ctre::sequence<Content...>>::value(after);
+    }
+};
+
+template<size_t A, size_t B, typename... Content>
+struct first_match_is_longest<ctre::possessive_repeat<A, B, Content...>>
+  : first_match_is_longest<ctre::repeat<A, B, Content...>>
+{};
+
+/**
+ * @brief whether a rule is translated into the automaton, which then matches it as CTRE does.
+ */
+template<typename Pattern>
+constexpr bool mergeable
+  = term<Pattern>::supported && first_match_is_longest<Pattern>::value(first_set{});
+
+/**
+ * @brief A partition of bytes, two bytes are in one class if every position either accepts both
+ * or neither of them.
+ */
+struct byte_classes
+{
+    uint8_t of[256]{};
+    size_t  count{1};
+};
+
+template<size_t N>
+constexpr byte_classes make_classes(const nfa<N>& automaton) {
+    // positions sharing a set of bytes split the classes the same way, consider them once.
+    byte_set distinct[N]{};
+    size_t   distinct_count = 0;
+    for (size_t position = 0; position < automaton.size; ++position) {
+        bool seen = false;
+        for (size_t i = 0; i < distinct_count && !seen; ++i)
+            seen = distinct[i] == automaton.symbols[position];
+        if (!seen) distinct[distinct_count++] = automaton.symbols[position];
+    }
+
+    byte_classes retval{};
+    for (size_t i = 0; i < distinct_count; ++i) {
+        int renumbered[512]{};
+        for (auto& id : renumbered) id = -1;
+
+        size_t count = 0;
+        for (size_t byte = 0; byte < 256; ++byte) {
+            auto& id = renumbered[retval.of[byte] * 2 + distinct[i].contains(byte)];
+            if (id < 0) id = static_cast<int>(count++);
+            retval.of[byte] = static_cast<uint8_t>(id);
+        }
+        retval.count = count;
+    }
+    return retval;
+}
+/**
+ * @brief The states of the deterministic automaton, before being trimmed to the real count.
+ */
+template<size_t N, size_t Classes, size_t MaxStates>
+struct state_builder
+{
+    position_set<N> sets[MaxStates]{};
+    state_id_t      next[MaxStates][Classes]{};
+    rule_id_t       accepts[MaxStates]{};
+    // holds state id + 1 so that zero marks a free slot.
+    state_id_t lookup[MaxStates * 2]{};
+    size_t     count{0};
+    bool       overflow{false};
+
+    constexpr state_id_t find_or_insert(const nfa<N>& automaton, const position_set<N>& set) {
+        auto slot = set.hash() % (MaxStates * 2);
+        for (; lookup[slot]; slot = (slot + 1) % (MaxStates * 2))
+            if (sets[lookup[slot] - 1] == set) return lookup[slot] - 1;
+
+        if (count == MaxStates) {
+            overflow = true;
+            return dead_state;
+        }
+
+        sets[count] = set;
+        accepts[count] = no_rule;
+        set.for_each([&](size_t position) {
+            if (automaton.accepts[position] < accepts[count])
+                accepts[count] = automaton.accepts[position];
+        });
+        lookup[slot] = static_cast<state_id_t>(count + 1);
+        return static_cast<state_id_t>(count++);
+    }
+};
+/**
+ * @brief the subset construction. The last position of the automaton is the start, followed by
+ * first positions of all rules.
+ */
+template<size_t MaxStates, size_t Classes, size_t N>
+constexpr auto make_states(const nfa<N>& automaton, const byte_classes& classes) {
+    // for each byte class the positions accepting it.
+    size_t representative[Classes]{};
+    for (size_t byte = 256; byte-- > 0;) representative[classes.of[byte]] = byte;
+
+    position_set<N> class_positions[Classes]{};
+    for (size_t position = 0; position < automaton.size; ++position)
+        for (size_t byte_class = 0; byte_class < Classes; ++byte_class)
+            if (automaton.symbols[position].contains(representative[byte_class]))
+                class_positions[byte_class].insert(position);
+
+    state_builder<N, Classes, MaxStates> retval{};
+    position_set<N>                      start{};
+    start.insert(N - 1);
+
+    retval.find_or_insert(automaton, position_set<N>{});
+    retval.find_or_insert(automaton, start);
+
+    for (size_t state = start_state; state < retval.count && !retval.overflow; ++state) {
+        position_set<N> reachable{};
+        retval.sets[state].for_each(
+          [&](size_t position) { reachable |= automaton.follow[position]; });
+
+        size_t candidates[64]{};
+        size_t candidate_count = 0;
+        reachable.for_each([&](size_t position) {
+            if (candidate_count < 64) candidates[candidate_count] = position;
+            ++candidate_count;
+        });
+
+        if (candidate_count > 64) {
+            for (size_t byte_class = 0; byte_class < Classes; ++byte_class)
+                retval.next[state][byte_class]
+                  = retval.find_or_insert(automaton, reachable & class_positions[byte_class]);
+            continue;
+        }
+        // usually only a few positions are reachable and most classes lead to the same state, so
+        // each class is described by which of them accept it and every distinct one is built once.
+        uint64_t   known_masks[Classes]{};
+        state_id_t known_states[Classes]{};
+        size_t     known_count = 0;
+        for (size_t byte_class = 0; byte_class < Classes; ++byte_class) {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < candidate_count; ++i)
+                if (automaton.symbols[candidates[i]].contains(representative[byte_class]))
+                    mask |= uint64_t{1} << i;
+
+            size_t known = 0;
+            while (known < known_count && known_masks[known] != mask) ++known;
+
+            if (known == known_count) {
+                position_set<N> next{};
+                for (size_t i = 0; i < candidate_count; ++i)
+                    if ((mask >> i) & 1) next.insert(candidates[i]);
+
+                known_masks[known_count] = mask;
+                known_states[known_count++] = retval.find_or_insert(automaton, next);
+            }
+            retval.next[state][byte_class] = known_states[known];
+        }
+    }
+    return retval;
+}
+
+/**
+ * @brief A deterministic automaton built from the rules of one state. It records the longest
+ * match of any rule and the first rule to accept it, the same as the lexer does rule by rule.
+ *
+ * @tparam MaxStates maximal number of states the subset construction may create.
+ * @tparam Patterns CTRE syntax trees of the rules, those which aren't mergeable are skipped.
+ */
+template<size_t MaxStates, typename... Patterns>
+class automaton
+{
+    static_assert(MaxStates <= std::numeric_limits<state_id_t>::max(), "Too many states.");
+    static_assert(sizeof...(Patterns) < no_rule, "Too many rules in one state.");
+
+    /** @brief all positions of all translated rules and one extra for the start. */
+    static constexpr size_t positions
+      = (1 + ... + (mergeable<Patterns> ? term<Patterns>::positions : 0));
+    static constexpr size_t start_position = positions - 1;
+
+    using nfa_t = nfa<positions>;
+
+    template<typename Pattern>
+    static constexpr void add_rule(nfa_t& automaton, rule_id_t rule) {
+        if constexpr (mergeable<Pattern>) {
+            auto rule_fragment = term<Pattern>::build(automaton);
+            automaton.follow[start_position] |= rule_fragment.first;
+            rule_fragment.last.for_each(
+              [&](size_t position) { automaton.accepts[position] = rule; });
+        }
+    }
+
+    static constexpr nfa_t make_nfa() {
+        nfa_t     retval{};
+        rule_id_t rule = 0;
+        (add_rule<Patterns>(retval, rule++), ...);
+        retval.accepts[start_position] = no_rule;
+        return retval;
+    }
+
+    static constexpr nfa_t  m_nfa = make_nfa();
+    static constexpr auto   m_classes = make_classes(m_nfa);
+    static constexpr size_t classes = m_classes.count;
+    static constexpr auto   m_builder = make_states<MaxStates, classes>(m_nfa, m_classes);
+    static_assert(!m_builder.overflow,
+                  "The automaton needs more states than allowed, raise MaxStates of dfa_matcher.");
+
+    static constexpr size_t states = m_builder.count;
+
+    static constexpr auto make_transitions() {
+        std::array<std::array<state_id_t, classes>, states> retval{};
+        for (size_t state = 0; state < states; ++state)
+            for (size_t byte_class = 0; byte_class < classes; ++byte_class)
+                retval[state][byte_class] = m_builder.next[state][byte_class];
+        return retval;
+    }
+
+    static constexpr auto make_accepts() {
+        std::array<rule_id_t, states> retval{};
+        for (size_t state = 0; state < states; ++state) retval[state] = m_builder.accepts[state];
+        return retval;
+    }
+
+    static constexpr auto make_byte_class() {
+        std::array<uint8_t, 256> retval{};
+        for (size_t byte = 0; byte < 256; ++byte) retval[byte] = m_classes.of[byte];
+        return retval;
+    }
+
+    static constexpr auto m_byte_class = make_byte_class();
+    static constexpr auto m_transitions = make_transitions();
+    static constexpr auto m_accepts = make_accepts();
+
+    static constexpr std::array<bool, sizeof...(Patterns)> m_compiled{mergeable<Patterns>...};
+
+public:
+    /** @brief the longest match found by the automaton and the first rule accepting it. */
+    struct result
+    {
+        size_t    length{0};
+        rule_id_t rule{no_rule};
+    };
+    /**
+     * @brief whether the rule on the index was translated into the automaton. If not, it has to
+     * be matched separately.
+     */
+    static constexpr bool compiled(size_t rule) noexcept { return m_compiled[rule]; }
+    /** @brief whether the automaton can match anything at all. */
+    static constexpr bool empty() noexcept { return positions == 1; }
+    /** @brief number of states, useful to check the size of generated tables. */
+    static constexpr size_t size() noexcept { return states; }
+    /**
+     * @brief runs the automaton on the input until it dies or the input ends.
+     *
+     * @param begin begin iterator, must dereference to a byte sized character.
+     * @param end end iterator.
+     * @return result the length of the longest match and the rule which matched it.
+     */
+    template<typename Iterator, typename EndIterator>
+    static constexpr CTRE_FORCE_INLINE result match(Iterator begin, EndIterator end) noexcept {
+        static_assert(sizeof(*begin) == 1, "The automaton can be used only for byte input.");
+
+        result     retval{};
+        state_id_t state = start_state;
+        for (size_t consumed = 1; begin != end; ++begin, ++consumed) {
+            state = m_transitions[state][m_byte_class[static_cast<uint8_t>(*begin)]];
+            if (state == dead_state) break;
+            if (auto rule = m_accepts[state]; rule != no_rule) retval = result{consumed, rule};
+        }
+        return retval;
+    }
+};
+} // namespace ctle::dfa
+
+#endif // CTLE_DFA
@@ -0,0 +1,78 @@
+#ifndef CTLE_DISPATCH
+#define CTLE_DISPATCH
+
+#include "regex_traits.h"
+
+#include <array>
+#include <cstdint>
+
+namespace ctle {
+/**
+ * @brief Splits bytes into classes by which rules of a state can start a match with them, so that
+ * for the first byte of a token only those rules have to be tried. Built at compile time from the
+ * first sets of the rules.
+ *
+ * @tparam Patterns CTRE syntax trees of the rules, in the order of the rules.
+ */
+template<typename... Patterns>
+class first_byte_table
+{
+public:
+    /** @brief for each rule whether it can start with a byte of the class. */
+    using candidates_t = std::array<bool, sizeof...(Patterns)>;
+
+private:
+    static constexpr size_t words = (sizeof...(Patterns) + 63) / 64 + 1;
+
+    struct table_t
+    {
+        uint8_t  of[256]{};
+        uint64_t masks[256][words]{};
+        size_t   count{0};
+    };
+
+    static constexpr bool same(const uint64_t (&a)[words], const uint64_t (&b)[words]) noexcept {
+        for (size_t i = 0; i < words; ++i)
+            if (a[i] != b[i]) return false;
+        return true;
+    }
+
+    static constexpr table_t make_table() {
+        // one more so that a state without rules has a valid array.
+        const byte_set firsts[]{first_of<Patterns>::value().bytes..., byte_set{}};
+
+        table_t retval{};
+        for (size_t byte = 0; byte < 256; ++byte) {
+            uint64_t mask[words]{};
+            for (size_t rule = 0; rule < sizeof...(Patterns); ++rule)
+                if (firsts[rule].contains(byte)) mask[rule / 64] |= uint64_t{1} << (rule % 64);
+
+            size_t byte_class = 0;
+            while (byte_class < retval.count && !same(retval.masks[byte_class], mask)) ++byte_class;
+
+            if (byte_class == retval.count) {
+                for (size_t i = 0; i < words; ++i) retval.masks[byte_class][i] = mask[i];
+                ++retval.count;
+            }
+            retval.of[byte] = static_cast<uint8_t>(byte_class);
+        }
+        return retval;
+    }
+
+    static constexpr table_t m_table = make_table();
+
+public:
+    /** @brief the number of byte classes. */
+    static constexpr size_t classes() noexcept { return m_table.count; }
+    /** @brief the class of a byte. */
+    static constexpr size_t byte_class(uint8_t byte) noexcept { return m_table.of[byte]; }
+    /** @brief the rules which can start with a byte of the class. */
+    static constexpr candidates_t candidates(size_t byte_class) noexcept {
+        candidates_t retval{};
+        for (size_t rule = 0; rule < retval.size(); ++rule)
+            retval[rule] = (m_table.masks[byte_class][rule / 64] >> (rule % 64)) & 1;
+        return retval;
+    }
+};
+} // namespace ctle
+#endif // CTLE_DISPATCH
@@ -0,0 +1,330 @@
+#ifndef CTLE_DRIVER
+#define CTLE_DRIVER
+
+#include "states.h"
+#include "token.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ctle {
+/**
+ * @brief Statistics of lexing many inputs, returned by ctle::parallel_driver::lex.
+ */
+struct lex_statistics
+{
+    /** @brief the number of inputs lexed. */
+    size_t files{0};
+    /** @brief the number of bytes lexed. */
+    size_t bytes{0};
+    /** @brief the number of tokens stored. */
+    size_t tokens{0};
+    /** @brief the wall clock time of lexing. */
+    double seconds{0};
+    /** @brief the number of chunks lexed again, see ctle::parallel_driver::lex_chunked. */
+    size_t relexed{0};
+    /** @brief the aggregate throughput of all workers. */
+    double bytes_per_second() const noexcept { return seconds > 0 ? bytes / seconds : 0; }
+};
+/**
+ * @brief Lexes many inputs (files, strings, ...) on all cores. Each worker owns a lexer and its own
+ * queue of inputs, the largest first, once its queue is empty it steals the largest input left in
+ * the queues of the others, so that a worker given large inputs doesn't keep the others waiting.
+ * An input is lexed by one worker, the tokens of each are stored to a buffer of its own.
+ *
+ * @tparam LexerT the type of the lexers, a ctle::lexer.
+ */
+template<typename LexerT>
+class parallel_driver
+{
+public:
+    using token_t = decltype(std::declval<LexerT&>().lex_compact());
+    using kind_t = decltype(token_t::kind);
+    using buffer_t = std::vector<token_t>;
+    /**
+     * @brief Construct a driver.
+     *
+     * @param workers the number of threads lexing, all cores if 0.
+     */
+    explicit parallel_driver(unsigned workers = 0) noexcept
+      : m_workers{workers ? workers : std::max(std::thread::hardware_concurrency(), 1u)} {}
+    /**
+     * @brief lexes inputs, each into its buffer, rethrows the first exception thrown by a lexer
+     * once all workers are done.
+     *
+     * @tparam InputT anything set_input accepts, such as ctle::basic_file or std::string_view.
+     * @tparam Last a predicate on kind_t.
+     * @param inputs the inputs, must outlive the buffers if lexemes are to be read from them.
+     * @param outputs the buffers, resized to the number of inputs.
+     * @param last tells which token ends an input (such as eof or no_match), it is stored too.
+     * @return lex_statistics the statistics of the whole run.
+     */
+    template<typename InputT, typename Last>
+    lex_statistics lex(const std::vector<InputT>& inputs, std::vector<buffer_t>& outputs,
+                       Last last);
+
+    /**
+     * @brief lexes a single large input on all cores. The input is split into a chunk per worker,
+     * each but the first begins after a newline near its boundary and is lexed speculatively in
+     * the initial state, while the others are lexed. The chunks are then stitched in order, once
+     * the tokens so far reach a token of the next chunk ending at the same position in the same
+     * state the rest of the chunk is taken as is, until then the chunk is lexed again. Actions may
+     * run more than once for a position, they should not have effects beyond the token returned
+     * and the state set.
+     *
+     * @tparam InputT anything set_input accepts, with random access iterators.
+     * @tparam Last a predicate on kind_t.
+     * @param input the input.
+     * @param output the buffer, the same tokens lex would store for the input.
+     * @param last tells which token ends the input (such as eof or no_match), it is stored too.
+     * @return lex_statistics the statistics of the whole run.
+     */
+    template<typename InputT, typename Last>
+    lex_statistics lex_chunked(const InputT& input, buffer_t& output, Last last);
+
+    unsigned workers() const noexcept { return m_workers; }
+    /** @brief inputs shorter than this per worker are split into fewer chunks. */
+    static constexpr size_t min_chunk_size = size_t{1} << 16;
+    /** @brief how far from its boundary a chunk may begin to begin after a newline. */
+    static constexpr size_t max_newline_distance = 4096;
+
+private:
+    /** @brief the queue of inputs of a worker, sorted by size. */
+    struct queue
+    {
+        std::mutex         mutex;
+        std::deque<size_t> inputs;
+    };
+
+    /** @brief the tokens of a chunk lexed speculatively and the state after each of them. */
+    struct chunk
+    {
+        size_t           begin{0};
+        size_t           end{0};
+        buffer_t         tokens;
+        std::vector<int> states;
+    };
+
+    /** @brief threads joined when it's destroyed, also when starting one of them throws. */
+    struct thread_group
+    {
+        std::vector<std::thread> threads;
+
+        ~thread_group() noexcept {
+            for (auto& thread : threads) thread.join();
+        }
+    };
+
+    unsigned m_workers;
+    /** @brief takes the largest input from the queue of a worker, or steals one. */
+    static bool take(queue* queues, unsigned count, unsigned worker, size_t& index) noexcept;
+    /**
+     * @brief finds where the tokens of a chunk go on from a position in a state.
+     *
+     * @return size_t the index of the token following, the number of tokens + 1 if there is none.
+     */
+    static size_t resume_point(const chunk& current, size_t position, int state) noexcept;
+};
+
+// implementation
+
+template<typename LexerT>
+template<typename InputT, typename Last>
+lex_statistics parallel_driver<LexerT>::lex(const std::vector<InputT>& inputs,
+                                            std::vector<buffer_t>& outputs, Last last) {
+    auto start = std::chrono::steady_clock::now();
+    outputs.resize(inputs.size());
+
+    auto size_of = [&](size_t index) {
+        const auto& input = inputs[index];
+        return static_cast<size_t>(std::distance(input.begin(), input.end()))
+               * sizeof(*input.begin());
+    };
+
+    std::vector<size_t> order(inputs.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](auto lhs, auto rhs) { return size_of(lhs) < size_of(rhs); });
+    // dealt from the largest, so each queue ends with its largest input.
+    auto queues = std::make_unique<queue[]>(m_workers);
+    for (size_t i = order.size(); i--;)
+        queues[(order.size() - 1 - i) % m_workers].inputs.push_front(order[i]);
+
+    std::exception_ptr  error;
+    std::mutex          error_mutex;
+    std::atomic<size_t> tokens{0};
+
+    auto work = [&](unsigned worker) {
+        LexerT lexer;
+        size_t index;
+        size_t stored = 0;
+        while (take(queues.get(), m_workers, worker, index)) {
+            try {
+                auto& output = outputs[index];
+                output.clear();
+                // whatever the previous input left the lexer in.
+                lexer.set_state(state_initial);
+                lexer.set_input(inputs[index]);
+                while (true) {
+                    output.push_back(lexer.lex_compact());
+                    if (last(output.back().kind)) break;
+                }
+                stored += output.size();
+            } catch (...) {
+                std::lock_guard lock{error_mutex};
+                if (!error) error = std::current_exception();
+            }
+        }
+        tokens += stored;
+    };
+
+    {
+        thread_group group;
+        for (unsigned worker = 1; worker < m_workers; ++worker)
+            group.threads.emplace_back(work, worker);
+        work(0);
+    }
+
+    if (error) std::rethrow_exception(error);
+
+    lex_statistics retval{inputs.size(), 0, tokens.load()};
+    for (size_t i = 0; i < inputs.size(); ++i) retval.bytes += size_of(i);
+    retval.seconds
+      = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return retval;
+}
+
+template<typename LexerT>
+template<typename InputT, typename Last>
+lex_statistics parallel_driver<LexerT>::lex_chunked(const InputT& input, buffer_t& output,
+                                                    Last last) {
+    using char_t = std::remove_cvref_t<decltype(*input.begin())>;
+
+    auto start = std::chrono::steady_clock::now();
+    auto first = input.begin();
+    auto size = static_cast<size_t>(std::distance(first, input.end()));
+
+    std::vector<chunk> chunks(std::clamp<size_t>(size / min_chunk_size, 1, m_workers));
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        auto boundary = size * i / chunks.size();
+        auto window = first + std::min(size, boundary + max_newline_distance);
+        auto newline = std::find(first + boundary, window, char_t('\n'));
+
+        chunks[i].begin = newline != window ? std::distance(first, newline) + 1 : boundary;
+        chunks[i - 1].end = chunks[i].begin;
+    }
+    // the last chunk goes on until the token ending the input.
+    chunks.back().end = std::numeric_limits<size_t>::max();
+    // lexes a chunk until a token ends past it, an exception just ends the speculation.
+    auto speculate = [&](chunk& current) noexcept {
+        try {
+            LexerT lexer;
+            lexer.set_input(input, first + current.begin);
+            while (true) {
+                auto token = lexer.lex_compact();
+                current.tokens.push_back(token);
+                current.states.push_back(lexer.get_state());
+                if (last(token.kind) || token.offset + token.length >= current.end) break;
+            }
+        } catch (...) {
+        }
+    };
+
+    {
+        thread_group group;
+        for (size_t i = 1; i < chunks.size(); ++i)
+            group.threads.emplace_back(speculate, std::ref(chunks[i]));
+        speculate(chunks.front());
+    }
+
+    lex_statistics retval{1, size * sizeof(char_t)};
+    output.clear();
+
+    size_t position = 0;
+    int    state = state_initial;
+    auto   done = false;
+    for (auto& current : chunks) {
+        LexerT lexer;
+        // takes the rest of the chunk if it goes on from the position, restarts the lexer after it.
+        auto splice = [&] {
+            auto from = resume_point(current, position, state);
+            if (from > current.tokens.size()) return;
+
+            output.insert(output.end(), current.tokens.begin() + from, current.tokens.end());
+            if (from < current.tokens.size()) {
+                position = output.back().offset + output.back().length;
+                state = current.states.back();
+                done = last(output.back().kind);
+            }
+
+            lexer.set_state(state);
+            lexer.set_input(input, first + position);
+        };
+
+        splice();
+        // the chunk began in another state or its speculation ended early.
+        if (!done && position < current.end) {
+            ++retval.relexed;
+            lexer.set_state(state);
+            lexer.set_input(input, first + position);
+        }
+
+        while (!done && position < current.end) {
+            output.push_back(lexer.lex_compact());
+            position = output.back().offset + output.back().length;
+            state = lexer.get_state();
+            done = last(output.back().kind);
+            if (!done) splice();
+        }
+    }
+
+    retval.tokens = output.size();
+    retval.seconds
+      = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return retval;
+}
+
+template<typename LexerT>
+size_t parallel_driver<LexerT>::resume_point(const chunk& current, size_t position,
+                                             int state) noexcept {
+    if (position == current.begin && state == state_initial) return 0;
+
+    const auto& tokens = current.tokens;
+    auto        it = std::partition_point(tokens.begin(), tokens.end(), [&](const auto& token) {
+        return token.offset + token.length < position;
+    });
+    for (; it != tokens.end() && it->offset + it->length == position; ++it) {
+        auto index = static_cast<size_t>(std::distance(tokens.begin(), it));
+        if (current.states[index] == state) return index + 1;
+    }
+    return tokens.size() + 1;
+}
+
+template<typename LexerT>
+bool parallel_driver<LexerT>::take(queue* queues, unsigned count, unsigned worker,
+                                   size_t& index) noexcept {
+    // the own queue first, then the others in turn.
+    for (unsigned i = 0; i < count; ++i) {
+        auto& current = queues[(worker + i) % count];
+
+        std::lock_guard lock{current.mutex};
+        if (current.inputs.empty()) continue;
+
+        index = current.inputs.back();
+        current.inputs.pop_back();
+        return true;
+    }
+    return false;
+}
+} // namespace ctle
+
+#endif // CTLE_DRIVER
@@ -1,5 +1,11 @@
 #ifndef CTLE_DERIVES_FROM
 #define CTLE_DERIVES_FROM
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
 namespace ctle {
 /**
  * @brief A wrapper for the extensions to allow multiple of them.
@@ -17,7 +23,44 @@ struct extensions
      */
     template<typename Ty>
     struct inner : Derivation<Ty>...
-    {};
+    {
+        /**
+         * @brief saves the states of the extensions which opt in, by providing save_state() and
+         * restore_state(state), see lexer::checkpoint.
+         *
+         * @return std::tuple the saved state of each extension, std::monostate if it has none.
+         */
+        auto save_extensions() const { return std::tuple{save_of<Derivation<Ty>>()...}; }
+        /**
+         * @brief restores the states of extensions saved by save_extensions.
+         *
+         * @param states the saved states.
+         */
+        template<typename States>
+        void restore_extensions(const States& states) {
+            restore_of<Derivation<Ty>...>(states, std::index_sequence_for<Derivation<Ty>...>());
+        }
+
+    private:
+        template<typename Extension>
+        auto save_of() const {
+            if constexpr (requires(const Extension& extension) { extension.save_state(); })
+                return static_cast<const Extension&>(*this).save_state();
+            else
+                return std::monostate{};
+        }
+
+        template<typename... Extension, typename States, size_t... Index>
+        void restore_of(const States& states, std::index_sequence<Index...>) {
+            (restore_one<Extension>(std::get<Index>(states)), ...);
+        }
+
+        template<typename Extension, typename State>
+        void restore_one(const State& state) {
+            if constexpr (!std::is_same_v<State, std::monostate>)
+                static_cast<Extension&>(*this).restore_state(state);
+        }
+    };
 };
 /**
  * @brief A base class all extensions to the lexer should use as base if they need to use the lexer
@@ -3,20 +3,44 @@
 
 #include "range.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <exception>
+#include <utility>
 
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
 namespace ctle {
+/**
+ * @brief Hints given to the kernel when a file is mapped. Lexing reads a file once from the
+ * beginning to the end, without hints most of the time may go to page faults on the first pass.
+ */
+struct map_policy
+{
+    /** @brief fault all pages in when mapping (MAP_POPULATE), instead of on first access. */
+    bool populate{false};
+    /** @brief the mapping is read sequentially, read ahead aggressively (MADV_SEQUENTIAL). */
+    bool sequential{false};
+    /** @brief the whole mapping is needed soon, start reading it in (MADV_WILLNEED). */
+    bool will_need{false};
+    /** @brief back the mapping by transparent huge pages if the kernel can (MADV_HUGEPAGE). */
+    bool huge_pages{false};
+    /** @brief the file is read sequentially, hint the page cache too (posix_fadvise). */
+    bool fadvise{false};
+    /** @brief the hints for lexing a file once, cold or warm. */
+    static constexpr map_policy sequential_read() noexcept {
+        return map_policy{false, true, true, false, true};
+    }
+};
 
 template<typename CharT>
 class basic_file
 {
-    int                 m_fd{0};
+    int                 m_fd{-1};
     utils::range<CharT> m_data; // default initialized by itself.
+    size_t              m_released{0}; // bytes at the beginning released by release_before.
 public:
     using char_t = CharT;
     using iterator_t = const char_t*;
@@ -24,8 +48,9 @@ public:
      * @brief Construct a file, opens the file, throws if cannot open or cannot map.
      *
      * @param path the path to the file.
+     * @param policy the hints given when mapping the file.
      */
-    basic_file(const std::filesystem::path& path);
+    basic_file(const std::filesystem::path& path, map_policy policy = {});
     /**
      * @brief Construct an empty file object. Needs initialize to be called.
      *
@@ -40,9 +65,19 @@ public:
      * @brief initializes the object. Should mimick the constructor argument wise.
      *
      * @param path the path to file.
+     * @param policy the hints given when mapping the file.
+     * @return true if success, false otherwise.
+     */
+    bool initialize(const std::filesystem::path& path, map_policy policy = {}) noexcept;
+    /**
+     * @brief initializes the object from a file opened already, which it closes then.
+     *
+     * @param fd the open file.
+     * @param bytes the size of the file in bytes.
+     * @param policy the hints given when mapping the file.
      * @return true if success, false otherwise.
      */
-    bool initialize(const std::filesystem::path& path) noexcept;
+    bool initialize(int fd, size_t bytes, map_policy policy = {}) noexcept;
     /**
      * @brief creates a file and initializes it.
      *
@@ -59,43 +94,73 @@ public:
     const CharT* end() const noexcept { return m_data.data + m_data.size; }
 
     size_t size() const noexcept { return m_data.size; }
+    /**
+     * @brief releases the pages of the file before an offset (MADV_DONTNEED), so that resident
+     * memory stays bounded when lexing a huge file. Characters before the offset, e.g. lexemes of
+     * tokens which are no longer needed, must not be read afterwards. Cheap if no whole page is
+     * to be released, so it can be called after every batch of tokens.
+     *
+     * @param offset the offset of the first character still needed.
+     * @return size_t the number of bytes released by this call.
+     */
+    size_t release_before(size_t offset) noexcept;
 
 private:
     bool open_file(const std::filesystem::path& path) noexcept;
-    bool map_memory() noexcept;
+    bool map_memory(map_policy policy) noexcept;
 };
 
 // implementation
 
 template<typename CharT>
-basic_file<CharT>::basic_file(const std::filesystem::path& path) {
+basic_file<CharT>::basic_file(const std::filesystem::path& path, map_policy policy) {
     if (!open_file(path)) throw std::runtime_error("File could not be opened.");
 
-    if (!map_memory()) throw std::runtime_error("File could not be mapped.");
+    if (!map_memory(policy)) throw std::runtime_error("File could not be mapped.");
 }
 
 template<typename CharT>
 basic_file<CharT>::~basic_file() noexcept {
-    if (m_data.data) munmap(m_data.data, m_data.size);
-    close(m_fd); // we dont care if fd is bad.
+    if (m_data.data) munmap(m_data.data, m_data.size * sizeof(CharT));
+    if (m_fd >= 0) close(m_fd);
 }
 
 template<typename CharT>
-bool basic_file<CharT>::initialize(const std::filesystem::path& path) noexcept {
-    return open_file(path) && map_memory();
+bool basic_file<CharT>::initialize(const std::filesystem::path& path, map_policy policy) noexcept {
+    return open_file(path) && map_memory(policy);
+}
+
+template<typename CharT>
+bool basic_file<CharT>::initialize(int fd, size_t bytes, map_policy policy) noexcept {
+    m_fd = fd;
+    m_data.size = bytes / sizeof(CharT);
+    return map_memory(policy);
 }
 
 template<typename CharT>
 template<typename... Args>
 std::unique_ptr<basic_file<CharT>> basic_file<CharT>::create(Args&&... args) noexcept {
-    auto retval = std::make_unique<basic_file>(std::forward<Args>(args)...);
+    auto retval = std::make_unique<basic_file>();
     return (retval->initialize(std::forward<Args>(args)...)) ? std::move(retval) : nullptr;
 }
 
+template<typename CharT>
+size_t basic_file<CharT>::release_before(size_t offset) noexcept {
+    static const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    // only whole pages can be released.
+    auto bytes = std::min(offset, m_data.size) * sizeof(CharT) / page_size * page_size;
+    if (bytes <= m_released) return 0;
+
+    auto first = reinterpret_cast<char*>(m_data.data) + m_released;
+    if (madvise(first, bytes - m_released, MADV_DONTNEED)) return 0;
+
+    return bytes - std::exchange(m_released, bytes);
+}
+
 template<typename CharT>
 bool basic_file<CharT>::open_file(const std::filesystem::path& path) noexcept {
     m_fd = open(path.c_str(), O_RDONLY);
-    if (!m_fd) return false;
+    if (m_fd < 0) return false;
 
     std::error_code err;
     // get size in CharT. (file_size reports in bytes).
@@ -105,10 +170,28 @@ bool basic_file<CharT>::open_file(const std::filesystem::path& path) noexcept {
 }
 
 template<typename CharT>
-bool basic_file<CharT>::map_memory() noexcept {
-    return (m_data.data
-            = (CharT*)mmap(NULL, m_data.size, PROT_READ, MAP_PRIVATE | MAP_FILE, m_fd, 0))
-           != nullptr;
+bool basic_file<CharT>::map_memory(map_policy policy) noexcept {
+    // an empty mapping can't be created, an empty file has no data.
+    if (!m_data.size) return true;
+
+    const auto bytes = m_data.size * sizeof(CharT);
+    if (policy.fadvise) posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    auto flags = MAP_PRIVATE | MAP_FILE;
+#ifdef MAP_POPULATE
+    if (policy.populate) flags |= MAP_POPULATE;
+#endif
+    auto data = mmap(NULL, bytes, PROT_READ, flags, m_fd, 0);
+    if (data == MAP_FAILED) return false;
+
+    m_data.data = static_cast<CharT*>(data);
+    // the hints are just hints, failing to give them doesn't matter.
+    if (policy.sequential) madvise(data, bytes, MADV_SEQUENTIAL);
+    if (policy.will_need) madvise(data, bytes, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    if (policy.huge_pages) madvise(data, bytes, MADV_HUGEPAGE);
+#endif
+    return true;
 }
 } // namespace ctle
 
@@ -0,0 +1,282 @@
+#ifndef CTLE_FILE_CACHE
+#define CTLE_FILE_CACHE
+
+#include "file.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+namespace ctle {
+/**
+ * @brief A cache of mapped files shared by lexers and threads, so that a file included by many
+ * others (such as a common header) is mapped once instead of once per include. A file is looked up
+ * by its device and inode, so that paths naming the same file (a/../f and f, links) share it, and
+ * is remapped if it changed since (its size or modification time differ, the inode was reused). The
+ * least recently used files are dropped once more than the capacity is mapped, a dropped file
+ * stays mapped until the last reference to it is gone. A file replaced by another one (renamed over
+ * it) has another inode, the old one stays cached until it's the least recently used.
+ *
+ * @tparam CharT the character type.
+ */
+template<typename CharT>
+class basic_file_cache
+{
+public:
+    using file_t = basic_file<CharT>;
+    using file_ptr = std::shared_ptr<const file_t>;
+    /** @brief the capacity used if none is specified, in bytes. */
+    static constexpr size_t default_capacity = size_t{1} << 30;
+    /**
+     * @brief Construct an empty cache.
+     *
+     * @param capacity the number of mapped bytes kept, more may be mapped while in use.
+     */
+    explicit basic_file_cache(size_t capacity = default_capacity) noexcept : m_capacity{capacity} {}
+
+    basic_file_cache(const basic_file_cache&) = delete;
+    basic_file_cache& operator=(const basic_file_cache&) = delete;
+    /**
+     * @brief gets a file from the cache, maps it if it isn't cached or changed since.
+     *
+     * @param path the path to the file.
+     * @param policy the hints given when mapping the file, if it's mapped.
+     * @return file_ptr the file, nullptr if it couldn't be opened or mapped.
+     */
+    file_ptr get(const std::filesystem::path& path, map_policy policy = {}) noexcept;
+    /**
+     * @brief drops all files, those in use stay mapped until the last reference is gone.
+     */
+    void clear() noexcept;
+
+    // accessors
+    size_t capacity() const noexcept { return m_capacity; }
+    /** @brief the number of bytes mapped by the cached files. */
+    size_t mapped_bytes() const noexcept;
+    /** @brief the number of cached files. */
+    size_t size() const noexcept;
+
+private:
+    /** @brief identifies the version of a file, it changed if any of these did. */
+    struct version
+    {
+        dev_t   device;
+        ino_t   inode;
+        off_t   bytes;
+        int64_t modified;
+
+        bool operator==(const version& other) const noexcept {
+            return device == other.device && inode == other.inode && bytes == other.bytes
+                   && modified == other.modified;
+        }
+    };
+
+    /** @brief identifies a file whichever path names it. */
+    struct file_id
+    {
+        dev_t device;
+        ino_t inode;
+
+        bool operator==(const file_id& other) const noexcept {
+            return device == other.device && inode == other.inode;
+        }
+    };
+
+    struct file_id_hash
+    {
+        size_t operator()(const file_id& id) const noexcept {
+            return std::hash<uint64_t>{}(static_cast<uint64_t>(id.inode) * 0x9e3779b97f4a7c15ull
+                                         ^ static_cast<uint64_t>(id.device));
+        }
+    };
+
+    struct entry
+    {
+        file_ptr                              file;
+        version                               stamp;
+        typename std::list<file_id>::iterator used;
+    };
+
+    using entries_t = std::unordered_map<file_id, entry, file_id_hash>;
+
+    mutable std::mutex m_mutex;
+    size_t             m_capacity;
+    size_t             m_mapped_bytes{0};
+    entries_t          m_entries;
+    /** @brief the files of the entries, the most recently used first. */
+    std::list<file_id> m_used;
+
+    static bool stat_file(const std::filesystem::path& path, version& stamp) noexcept;
+    /** @brief drops an entry, the lock must be held. */
+    void drop(typename entries_t::iterator it) noexcept;
+};
+/**
+ * @brief A file taken from a ctle::basic_file_cache, so that it can be used wherever a
+ * ctle::basic_file is, such as by ctle::basic_file_stack (push(cache, path)).
+ *
+ * @tparam CharT the character type.
+ */
+template<typename CharT>
+class basic_cached_file
+{
+    typename basic_file_cache<CharT>::file_ptr m_file;
+
+public:
+    using char_t = CharT;
+    using iterator_t = const char_t*;
+    /**
+     * @brief Construct a file, takes it from the cache, throws if cannot.
+     *
+     * @param cache the cache.
+     * @param path the path to the file.
+     * @param policy the hints given when mapping the file, if it's mapped.
+     */
+    basic_cached_file(basic_file_cache<CharT>& cache, const std::filesystem::path& path,
+                      map_policy policy = {});
+    /**
+     * @brief Construct an empty file object. Needs initialize to be called.
+     *
+     */
+    basic_cached_file() noexcept = default;
+    /**
+     * @brief initializes the object. Should mimick the constructor argument wise.
+     *
+     * @param cache the cache.
+     * @param path the path to file.
+     * @param policy the hints given when mapping the file, if it's mapped.
+     * @return true if success, false otherwise.
+     */
+    bool initialize(basic_file_cache<CharT>& cache, const std::filesystem::path& path,
+                    map_policy policy = {}) noexcept;
+    /**
+     * @brief creates a file and initializes it.
+     *
+     * @tparam Args variadic.
+     * @param args to pass to initialize.
+     * @return std::unique_ptr<basic_cached_file> if success, false otherwise.
+     */
+    template<typename... Args>
+    static std::unique_ptr<basic_cached_file> create(Args&&... args) noexcept;
+
+    // accessors
+    const CharT* begin() const noexcept { return m_file ? m_file->begin() : nullptr; }
+
+    const CharT* end() const noexcept { return m_file ? m_file->end() : nullptr; }
+
+    size_t size() const noexcept { return m_file ? m_file->size() : 0; }
+};
+
+// implementation
+
+template<typename CharT>
+typename basic_file_cache<CharT>::file_ptr
+  basic_file_cache<CharT>::get(const std::filesystem::path& path, map_policy policy) noexcept {
+    try {
+        version stamp;
+        if (!stat_file(path, stamp)) return nullptr;
+
+        auto key = file_id{stamp.device, stamp.inode};
+        {
+            std::lock_guard lock{m_mutex};
+            if (auto it = m_entries.find(key); it != m_entries.end()) {
+                if (it->second.stamp == stamp) {
+                    m_used.splice(m_used.begin(), m_used, it->second.used);
+                    return it->second.file;
+                }
+                // the file changed, the old mapping stays valid for those using it.
+                drop(it);
+            }
+        }
+        // mapped without holding the lock, so that misses on other files don't wait for it.
+        file_ptr file = file_t::create(path, policy);
+        if (!file) return nullptr;
+
+        std::lock_guard lock{m_mutex};
+        // another thread may have mapped the file in the meantime.
+        if (auto it = m_entries.find(key); it != m_entries.end()) {
+            if (it->second.stamp == stamp) return it->second.file;
+
+            drop(it);
+        }
+
+        m_used.push_front(key);
+        m_entries.emplace(key, entry{file, stamp, m_used.begin()});
+        m_mapped_bytes += file->size() * sizeof(CharT);
+        // the file just mapped is kept even if it alone exceeds the capacity.
+        while (m_mapped_bytes > m_capacity && m_used.size() > 1)
+            drop(m_entries.find(m_used.back()));
+
+        return file;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+template<typename CharT>
+void basic_file_cache<CharT>::clear() noexcept {
+    std::lock_guard lock{m_mutex};
+    m_entries.clear();
+    m_used.clear();
+    m_mapped_bytes = 0;
+}
+
+template<typename CharT>
+size_t basic_file_cache<CharT>::mapped_bytes() const noexcept {
+    std::lock_guard lock{m_mutex};
+    return m_mapped_bytes;
+}
+
+template<typename CharT>
+size_t basic_file_cache<CharT>::size() const noexcept {
+    std::lock_guard lock{m_mutex};
+    return m_entries.size();
+}
+
+template<typename CharT>
+bool basic_file_cache<CharT>::stat_file(const std::filesystem::path& path,
+                                        version&                     stamp) noexcept {
+    struct stat status;
+    if (stat(path.c_str(), &status)) return false;
+
+    stamp = version{status.st_dev, status.st_ino, status.st_size,
+                    int64_t{status.st_mtim.tv_sec} * 1'000'000'000 + status.st_mtim.tv_nsec};
+    return true;
+}
+
+template<typename CharT>
+void basic_file_cache<CharT>::drop(typename entries_t::iterator it) noexcept {
+    m_mapped_bytes -= it->second.file->size() * sizeof(CharT);
+    m_used.erase(it->second.used);
+    m_entries.erase(it);
+}
+
+template<typename CharT>
+basic_cached_file<CharT>::basic_cached_file(basic_file_cache<CharT>&     cache,
+                                            const std::filesystem::path& path, map_policy policy) {
+    if (!initialize(cache, path, policy)) throw std::runtime_error("File could not be opened.");
+}
+
+template<typename CharT>
+bool basic_cached_file<CharT>::initialize(basic_file_cache<CharT>&     cache,
+                                          const std::filesystem::path& path,
+                                          map_policy                   policy) noexcept {
+    m_file = cache.get(path, policy);
+    return static_cast<bool>(m_file);
+}
+
+template<typename CharT>
+template<typename... Args>
+std::unique_ptr<basic_cached_file<CharT>>
+  basic_cached_file<CharT>::create(Args&&... args) noexcept {
+    auto retval = std::make_unique<basic_cached_file>();
+    return (retval->initialize(std::forward<Args>(args)...)) ? std::move(retval) : nullptr;
+}
+} // namespace ctle
+
+#endif // CTLE_FILE_CACHE
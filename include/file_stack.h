@@ -70,6 +70,18 @@ public:
 
         return file_range{current.first->begin() + current.second, current.first->end()};
     }
+    /**
+     * @brief returns the file on top of the stack.
+     *
+     * @return const file_t* the file, nullptr if the stack is empty.
+     */
+    const file_t* top_file() const noexcept {
+        return m_files.empty() ? nullptr : m_files.back().first.get();
+    }
+    /**
+     * @brief returns the number of files on the stack.
+     */
+    size_t size() const noexcept { return m_files.size(); }
 };
 
 } // namespace ctle
@@ -0,0 +1,241 @@
+#ifndef CTLE_GENERATOR
+#define CTLE_GENERATOR
+
+// coroutines need a compiler supporting them (GCC 10 with -fcoroutines or later).
+#if !__has_include(<coroutine>) || !defined(__cpp_impl_coroutine)
+#error "generator.h needs coroutines, e.g. GCC 10 or later with -std=c++20 -fcoroutines."
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <utility>
+
+namespace ctle {
+/**
+ * @brief Recycles the frames of coroutines (such as those of ctle::token_generator) per thread, a
+ * frame freed is kept in a list by its size class and reused by the next frame of that class, so
+ * that creating generators doesn't allocate once as many were created as live at once.
+ */
+class frame_arena
+{
+    /** @brief the smallest size class is 2^min_class bytes, the largest 2^max_class. */
+    static constexpr size_t min_class = 6;
+    static constexpr size_t max_class = 16;
+
+    struct free_frame
+    {
+        free_frame* next;
+    };
+
+    struct lists
+    {
+        free_frame* heads[max_class - min_class + 1]{};
+
+        ~lists() noexcept {
+            for (auto head : heads)
+                while (head) ::operator delete(std::exchange(head, head->next));
+        }
+    };
+
+    static lists& local() noexcept {
+        thread_local lists retval;
+        return retval;
+    }
+
+    static constexpr size_t size_class(size_t size) noexcept {
+        size_t retval = min_class;
+        while ((size_t{1} << retval) < size) ++retval;
+        return retval;
+    }
+
+public:
+    /** @brief allocates a frame, from the list of its class if there is one. */
+    static void* allocate(size_t size) {
+        auto index = size_class(size);
+        if (index > max_class) return ::operator new(size);
+
+        auto& head = local().heads[index - min_class];
+        if (!head) return ::operator new(size_t{1} << index);
+
+        return std::exchange(head, head->next);
+    }
+    /** @brief frees a frame to the list of its class, size must be as allocated. */
+    static void deallocate(void* frame, size_t size) noexcept {
+        auto index = size_class(size);
+        if (index > max_class) return ::operator delete(frame);
+
+        auto& head = local().heads[index - min_class];
+        head = new (frame) free_frame{head};
+    }
+};
+/**
+ * @brief Tokens produced lazily by a coroutine, see ctle::make_token_generator. Iterating it lexes
+ * a token whenever the next is needed, so a parser pulls tokens instead of being called back and
+ * many inputs can be lexed interleaved on one thread. Frames come from ctle::frame_arena. Iterating
+ * and next share the current token, it's consumed once returned by next or once an iterator to it
+ * is advanced, whichever is used next goes on with the token after it.
+ *
+ * @tparam TokenT the type of tokens.
+ */
+template<typename TokenT>
+class token_generator
+{
+public:
+    struct promise_type
+    {
+        TokenT             m_current{};
+        std::exception_ptr m_error;
+
+        token_generator get_return_object() noexcept {
+            return token_generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+
+        std::suspend_always final_suspend() const noexcept { return {}; }
+
+        std::suspend_always yield_value(TokenT token) noexcept {
+            m_current = std::move(token);
+            return {};
+        }
+
+        void return_void() const noexcept {}
+
+        void unhandled_exception() noexcept { m_error = std::current_exception(); }
+
+        static void* operator new(size_t size) { return frame_arena::allocate(size); }
+
+        static void operator delete(void* frame, size_t size) noexcept {
+            frame_arena::deallocate(frame, size);
+        }
+    };
+
+    using handle_t = std::coroutine_handle<promise_type>;
+    /** @brief an input iterator over the tokens, advancing it lexes the next one. */
+    class iterator
+    {
+        token_generator* m_generator;
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = TokenT;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const TokenT*;
+        using reference = const TokenT&;
+
+        explicit iterator(token_generator* generator = nullptr) noexcept
+          : m_generator{generator} {}
+
+        reference operator*() const noexcept { return m_generator->current(); }
+
+        pointer operator->() const noexcept { return &m_generator->current(); }
+
+        iterator& operator++() {
+            m_generator->m_consumed = true;
+            m_generator->fill();
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(const iterator& other) const noexcept {
+            return done() == other.done();
+        }
+
+        bool operator!=(const iterator& other) const noexcept { return !(*this == other); }
+
+    private:
+        bool done() const noexcept { return !m_generator || m_generator->done(); }
+    };
+
+    explicit token_generator(handle_t handle) noexcept : m_handle{handle} {}
+
+    token_generator(token_generator&& other) noexcept
+      : m_handle{std::exchange(other.m_handle, nullptr)} {}
+
+    token_generator& operator=(token_generator other) noexcept {
+        std::swap(m_handle, other.m_handle);
+        return *this;
+    }
+    /**
+     * @brief Destructor, destroys the coroutine, also when it wasn't done.
+     *
+     */
+    ~token_generator() noexcept {
+        if (m_handle) m_handle.destroy();
+    }
+    /**
+     * @brief lexes the first token not consumed yet, iterating again goes on where it stopped.
+     *
+     * @return iterator to the token, equal to end() once the last token was passed.
+     * @throws what lexing threw.
+     */
+    iterator begin() {
+        fill();
+        return iterator{this};
+    }
+
+    iterator end() const noexcept { return iterator{}; }
+    /**
+     * @brief lexes the next token.
+     *
+     * @param token the token.
+     * @return true if lexed, false once the last token was passed.
+     */
+    bool next(TokenT& token) {
+        fill();
+        if (done()) return false;
+
+        token = current();
+        m_consumed = true;
+        return true;
+    }
+
+private:
+    handle_t m_handle;
+    /** @brief whether the token in the promise was consumed, true before the first one. */
+    bool m_consumed{true};
+    /** @brief lexes the next token if the current one was consumed. */
+    void fill() {
+        if (!m_consumed || done()) return;
+
+        m_consumed = false;
+        resume(m_handle);
+    }
+
+    bool done() const noexcept { return !m_handle || m_handle.done(); }
+
+    const TokenT& current() const noexcept { return m_handle.promise().m_current; }
+
+    static void resume(handle_t handle) {
+        handle.resume();
+        if (handle.done() && handle.promise().m_error)
+            std::rethrow_exception(std::exchange(handle.promise().m_error, nullptr));
+    }
+};
+/**
+ * @brief lexes an input lazily, a token whenever the generator is advanced.
+ *
+ * @tparam LexerT the type of the lexer, a ctle::lexer.
+ * @tparam Last a predicate on the kind of a token.
+ * @param lexer the lexer with its input set, must outlive the generator.
+ * @param last tells which token ends the input (such as eof or no_match), it is generated too.
+ * @return token_generator the tokens as returned by lex.
+ */
+template<typename LexerT, typename Last>
+token_generator<decltype(std::declval<LexerT&>().lex())> make_token_generator(LexerT& lexer,
+                                                                              Last    last) {
+    while (true) {
+        auto token = lexer.lex();
+        auto done = last(std::get<0>(token));
+        co_yield std::move(token);
+        if (done) co_return;
+    }
+}
+} // namespace ctle
+
+#endif // CTLE_GENERATOR
@@ -0,0 +1,72 @@
+#ifndef CTLE_INCLUDE_STACK
+#define CTLE_INCLUDE_STACK
+
+#include "file_stack.h"
+
+#include <utility>
+
+namespace ctle {
+/**
+ * @brief An extension which lexes files included by others (such as by #include) in place. An
+ * action includes a file, the lexer goes on in it and once it ends goes back to the file which
+ * included it, without returning to the caller. Lexemes are valid until the file they are in ends,
+ * offsets of tokens (lex_batch, lex_compact) are from the beginning of the file they are in.
+ *
+ * @tparam FileType the type of the files, such as ctle::basic_file<char>.
+ */
+template<typename FileType>
+struct include_stack
+{
+    /**
+     * @brief the extension itself, pass include_stack<FileType>::template inner to
+     * ctle::extensions.
+     *
+     * @tparam LexerT the type of the lexer (CRTP).
+     */
+    template<typename LexerT>
+    class inner
+    {
+        basic_file_stack<FileType> m_files;
+
+    public:
+        /**
+         * @brief opens a file and lexes it from the next match on. The position in the current
+         * file is stored, it is lexed from there once the included file ends. The first file is
+         * included the same way, instead of calling set_input.
+         *
+         * @tparam Args variadic.
+         * @param args passed to FileType::create.
+         * @return true if success, false if the file couldn't be opened (nothing changes then).
+         */
+        template<typename... Args>
+        bool include(Args&&... args) noexcept {
+            m_files.store(lexer().get_input().begin);
+            if (!m_files.push(std::forward<Args>(args)...)) return false;
+
+            lexer().set_input(*m_files.top_file());
+            return true;
+        }
+        /**
+         * @brief called by the lexer at the end of its input, goes back to the file which included
+         * the current one.
+         *
+         * @return true if there is such a file, false if the lexer should run its eof action.
+         */
+        bool on_eof() noexcept {
+            if (m_files.empty()) return false;
+
+            m_files.pop();
+            if (m_files.empty()) return false;
+
+            lexer().set_input(*m_files.top_file(), m_files.top().begin);
+            return true;
+        }
+        /** @brief the number of files being lexed, the current one and those including it. */
+        size_t include_depth() const noexcept { return m_files.size(); }
+
+    private:
+        LexerT& lexer() noexcept { return static_cast<LexerT&>(*this); }
+    };
+};
+} // namespace ctle
+#endif // CTLE_INCLUDE_STACK
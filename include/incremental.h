@@ -0,0 +1,228 @@
+#ifndef CTLE_INCREMENTAL
+#define CTLE_INCREMENTAL
+
+#include "states.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ctle {
+/**
+ * @brief Which tokens an edit replaced, returned by ctle::incremental_lexer::update. The old tokens
+ * [first, first + erased) were replaced by the new ones [first, first + inserted).
+ */
+struct token_edit
+{
+    size_t first{0};
+    size_t erased{0};
+    size_t inserted{0};
+};
+/**
+ * @brief Keeps the tokens of an input with the state after each of them, so that after an edit
+ * only the tokens around it are lexed again (such as in an editor, on every keystroke). Lexing
+ * starts at the last token ending before the edit and stops once a token ends where an old one
+ * ended (moved by the edit) in the same state, the tokens from there on are the old ones. The
+ * tokens are kept in a gap buffer with the gap at the last edit, those after the gap store their
+ * offset from the end of the input, so that the tokens after an edit don't change with it and an
+ * edit costs the tokens lexed again and the distance from the previous edit.
+ *
+ * @tparam LexerT the type of the lexer, a ctle::lexer.
+ * @tparam Last a predicate on the kind of a token, which tells which token ends the input.
+ */
+template<typename LexerT, typename Last>
+class incremental_lexer
+{
+public:
+    using token_t = decltype(std::declval<LexerT&>().lex_compact());
+    /**
+     * @brief Construct an incremental lexer, without tokens.
+     *
+     * @param last tells which token ends the input (such as eof or no_match), it is kept too.
+     * @param lookahead how many characters after a token may decide where it ends, lexing starts
+     * at least this far before an edit. 1 if the rules match runs of characters (identifiers,
+     * whitespace, ...), the length of the longest rule but one if they match fixed operators, the
+     * length of the longest token if a rule may match a prefix of another token (such as an
+     * unterminated string of a string literal).
+     */
+    incremental_lexer(Last last, size_t lookahead)
+      : m_last{std::move(last)}, m_lookahead{lookahead} {}
+    /**
+     * @brief lexes a whole input.
+     *
+     * @param input the input, anything set_input accepts with random access iterators.
+     */
+    template<typename InputT>
+    void lex(const InputT& input);
+    /**
+     * @brief lexes an input again after an edit, reusing the tokens not affected by it.
+     *
+     * @param input the input after the edit.
+     * @param begin the offset the edit begins at.
+     * @param removed the number of characters the edit removed from begin on.
+     * @param inserted the number of characters the edit inserted at begin instead.
+     * @return token_edit which tokens changed.
+     */
+    template<typename InputT>
+    token_edit update(const InputT& input, size_t begin, size_t removed, size_t inserted);
+
+    // accessors
+    /** @brief the number of tokens. */
+    size_t size() const noexcept { return m_entries.size() - (m_gap_end - m_gap_begin); }
+    /** @brief a token, with its offset from the beginning of the input. */
+    token_t token(size_t index) const noexcept;
+    /** @brief the identifier of the state after a token. */
+    int state(size_t index) const noexcept { return m_entries[physical(index)].state; }
+    /** @brief all the tokens, copied. */
+    std::vector<token_t> tokens() const;
+
+private:
+    /** @brief a token and the state after it. */
+    struct entry
+    {
+        token_t token;
+        int     state;
+    };
+
+    LexerT             m_lexer;
+    Last               m_last;
+    size_t             m_lookahead;
+    std::vector<entry> m_entries;
+    size_t             m_gap_begin{0};
+    size_t             m_gap_end{0};
+    /** @brief the size of the input, the tokens after the gap are offset from its end. */
+    size_t m_size{0};
+
+    static size_t end_of(const token_t& token) noexcept { return token.offset + token.length; }
+
+    size_t physical(size_t index) const noexcept {
+        return index < m_gap_begin ? index : index + (m_gap_end - m_gap_begin);
+    }
+    /** @brief moves the gap to begin before a token. */
+    void move_gap(size_t index) noexcept;
+    /** @brief replaces tokens by others at the gap, which is moved to the first of them. */
+    void replace(size_t first, size_t count, const std::vector<entry>& entries);
+};
+
+// implementation
+
+template<typename LexerT, typename Last>
+template<typename InputT>
+void incremental_lexer<LexerT, Last>::lex(const InputT& input) {
+    m_entries.clear();
+    m_size = static_cast<size_t>(std::distance(input.begin(), input.end()));
+
+    m_lexer.set_state(state_initial);
+    m_lexer.set_input(input);
+    while (true) {
+        m_entries.push_back(entry{m_lexer.lex_compact(), m_lexer.get_state()});
+        if (m_last(m_entries.back().token.kind)) break;
+    }
+    m_gap_begin = m_gap_end = m_entries.size();
+}
+
+template<typename LexerT, typename Last>
+template<typename InputT>
+token_edit incremental_lexer<LexerT, Last>::update(const InputT& input, size_t begin,
+                                                   size_t removed, size_t inserted) {
+    // the first token which may change, those before end far enough from the edit.
+    size_t first = 0;
+    for (auto count = size(); count;) {
+        auto half = count / 2;
+        if (end_of(token(first + half)) + m_lookahead <= begin) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+
+    auto start = first ? end_of(token(first - 1)) : 0;
+    m_lexer.set_state(first ? state(first - 1) : state_initial);
+    m_lexer.set_input(input, input.begin() + start);
+
+    std::vector<entry> entries;
+    // the first old token kept, all of them are replaced unless lexing meets one.
+    auto resume = size();
+    auto old = first;
+    while (true) {
+        entries.push_back(entry{m_lexer.lex_compact(), m_lexer.get_state()});
+        if (m_last(entries.back().token.kind)) break;
+
+        auto end = end_of(entries.back().token);
+        if (end < begin + inserted) continue;
+        // past the edit, where the old tokens end.
+        auto moved = end - inserted + removed;
+        while (old < size() && end_of(token(old)) < moved) ++old;
+
+        auto met = old;
+        while (met < size() && end_of(token(met)) == moved && state(met) != entries.back().state)
+            ++met;
+
+        // an empty token (eof) ending there begins there too, it's kept.
+        if (met < size() && end_of(token(met)) == moved) {
+            resume = token(met).length ? met + 1 : met;
+            break;
+        }
+    }
+
+    replace(first, resume - first, entries);
+    // the tokens after the gap are offset from the end, they move with it.
+    m_size = m_size + inserted - removed;
+    return token_edit{first, resume - first, entries.size()};
+}
+
+template<typename LexerT, typename Last>
+typename incremental_lexer<LexerT, Last>::token_t
+  incremental_lexer<LexerT, Last>::token(size_t index) const noexcept {
+    auto retval = m_entries[physical(index)].token;
+    if (index >= m_gap_begin) retval.offset = static_cast<uint32_t>(m_size - retval.offset);
+    return retval;
+}
+
+template<typename LexerT, typename Last>
+std::vector<typename incremental_lexer<LexerT, Last>::token_t>
+  incremental_lexer<LexerT, Last>::tokens() const {
+    std::vector<token_t> retval;
+    retval.reserve(size());
+    for (size_t i = 0; i < size(); ++i) retval.push_back(token(i));
+    return retval;
+}
+
+template<typename LexerT, typename Last>
+void incremental_lexer<LexerT, Last>::move_gap(size_t index) noexcept {
+    // the tokens crossing the gap change between being offset from the beginning and the end.
+    for (; m_gap_begin > index; --m_gap_begin) {
+        auto& moved = m_entries[--m_gap_end] = m_entries[m_gap_begin - 1];
+        moved.token.offset = static_cast<uint32_t>(m_size - moved.token.offset);
+    }
+    for (; m_gap_begin < index; ++m_gap_end) {
+        auto& moved = m_entries[m_gap_begin++] = m_entries[m_gap_end];
+        moved.token.offset = static_cast<uint32_t>(m_size - moved.token.offset);
+    }
+}
+
+template<typename LexerT, typename Last>
+void incremental_lexer<LexerT, Last>::replace(size_t first, size_t count,
+                                              const std::vector<entry>& entries) {
+    move_gap(first);
+    m_gap_end += count;
+    // grows the gap to as many entries as are kept, so that growing is amortized.
+    if (m_gap_end - m_gap_begin < entries.size()) {
+        auto after = m_entries.size() - m_gap_end;
+        auto gap = std::max(entries.size(), m_gap_begin + after);
+
+        std::vector<entry> grown(m_gap_begin + gap + after);
+        std::copy(m_entries.begin(), m_entries.begin() + m_gap_begin, grown.begin());
+        std::copy(m_entries.begin() + m_gap_end, m_entries.end(), grown.end() - after);
+        m_entries = std::move(grown);
+        m_gap_end = m_gap_begin + gap;
+    }
+
+    std::copy(entries.begin(), entries.end(), m_entries.begin() + m_gap_begin);
+    m_gap_begin += entries.size();
+}
+} // namespace ctle
+
+#endif // CTLE_INCREMENTAL
@@ -0,0 +1,67 @@
+#ifndef CTLE_INTERNING
+#define CTLE_INTERNING
+
+#include "symbol_table.h"
+
+#include <memory>
+#include <utility>
+
+namespace ctle {
+/**
+ * @brief An extension which interns lexemes (such as identifiers) into a ctle::basic_symbol_table,
+ * so that an action returns a token with a symbol_id instead of the lexeme. The lexeme is hashed
+ * once, by looking up keywords if its rule has any (see lexer::lexeme_hash) or while interning,
+ * the table keeps the hash so that later lookups don't hash the text again.
+ * Lexers sharing a table (one at a time) give the same text the same symbol across inputs.
+ *
+ * @tparam SymbolTableT the type of the table, such as ctle::symbol_table.
+ */
+template<typename SymbolTableT = symbol_table>
+struct interning
+{
+    /**
+     * @brief the extension itself, pass interning<SymbolTableT>::template inner to
+     * ctle::extensions.
+     *
+     * @tparam LexerT the type of the lexer (CRTP).
+     */
+    template<typename LexerT>
+    class inner
+    {
+        std::shared_ptr<SymbolTableT> m_symbols;
+
+    public:
+        using string_view_t = typename SymbolTableT::string_view_t;
+        /**
+         * @brief interns a lexeme, called by an action.
+         *
+         * @param lexeme the lexeme.
+         * @return symbol_id the symbol of the lexeme.
+         */
+        symbol_id intern(string_view_t lexeme) {
+            return symbols().intern(lexeme, lexer().lexeme_hash(lexeme));
+        }
+        /**
+         * @brief the table symbols are interned into, created by the first call if none was shared.
+         */
+        SymbolTableT& symbols() {
+            if (!m_symbols) m_symbols = std::make_shared<SymbolTableT>();
+            return *m_symbols;
+        }
+        /**
+         * @brief interns into a table shared with other lexers from now on.
+         *
+         * @param symbols the table.
+         */
+        void share_symbols(std::shared_ptr<SymbolTableT> symbols) noexcept {
+            m_symbols = std::move(symbols);
+        }
+        /** @brief the table, to be shared with other lexers, nullptr if none was used yet. */
+        const std::shared_ptr<SymbolTableT>& shared_symbols() const noexcept { return m_symbols; }
+
+    private:
+        const LexerT& lexer() const noexcept { return static_cast<const LexerT&>(*this); }
+    };
+};
+} // namespace ctle
+#endif // CTLE_INTERNING
@@ -0,0 +1,233 @@
+#ifndef CTLE_KEYWORDS
+#define CTLE_KEYWORDS
+
+#include "regex_traits.h"
+#include "utils.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+namespace ctle {
+/**
+ * @brief Finds rules which are plain literals (keywords) and whose every match is matched by a
+ * rule matching runs of characters (an identifier) too. Such keyword can only win if the
+ * identifier matches exactly it, so instead of being tried on its own it's looked up in a perfect
+ * hash of the keywords after the identifier has matched. A keyword specified after its identifier
+ * can never win and is not looked up at all.
+ *
+ * @tparam Patterns CTRE syntax trees of the rules, in the order of the rules.
+ */
+template<typename... Patterns>
+class keyword_table
+{
+public:
+    /** @brief marks no rule. */
+    static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+private:
+    static constexpr size_t rules = sizeof...(Patterns);
+
+    struct class_run_t
+    {
+        bool     valid{false};
+        byte_set head{};
+        byte_set tail{};
+
+        constexpr bool matches(std::string_view text) const noexcept {
+            if (!valid || text.empty() || !head.contains(static_cast<uint8_t>(text[0])))
+                return false;
+
+            for (size_t i = 1; i < text.size(); ++i)
+                if (!tail.contains(static_cast<uint8_t>(text[i]))) return false;
+            return true;
+        }
+    };
+
+    template<typename Pattern>
+    static constexpr std::string_view make_literal() noexcept {
+        using text_t = literal_text<typename literal_of<Pattern>::type>;
+        if constexpr (text_t::valid)
+            return std::string_view{text_t::value, text_t::size};
+        else
+            return std::string_view{};
+    }
+
+    template<typename Pattern>
+    static constexpr class_run_t make_class_run() noexcept {
+        using run_t = class_run_of<Pattern>;
+        if constexpr (run_t::value)
+            return class_run_t{true, run_t::head(), run_t::tail()};
+        else
+            return class_run_t{};
+    }
+    // one more element so that a state without rules has valid arrays.
+    static constexpr std::string_view m_literals[rules + 1]{make_literal<Patterns>()..., {}};
+    static constexpr class_run_t      m_class_runs[rules + 1]{make_class_run<Patterns>()..., {}};
+    /** @brief for each rule the first class run which matches all it does, if it is a literal. */
+    static constexpr auto make_absorbed() noexcept {
+        std::array<size_t, rules> retval{};
+        for (size_t rule = 0; rule < rules; ++rule) {
+            retval[rule] = none;
+            for (size_t run = 0; run < rules && retval[rule] == none; ++run)
+                if (m_class_runs[run].matches(m_literals[rule])) retval[rule] = run;
+        }
+        return retval;
+    }
+
+    static constexpr auto m_absorbed = make_absorbed();
+    /**
+     * @brief whether a keyword is looked up after an identifier. Of equal keywords only the first
+     * is, it's the one which wins.
+     */
+    static constexpr bool looked_up(size_t rule, size_t identifier) noexcept {
+        if (rule >= identifier || m_absorbed[rule] != identifier) return false;
+
+        for (size_t earlier = 0; earlier < rule; ++earlier)
+            if (m_absorbed[earlier] == identifier && m_literals[earlier] == m_literals[rule])
+                return false;
+        return true;
+    }
+    /** @brief the number of keywords looked up after an identifier. */
+    static constexpr size_t keyword_count(size_t identifier) noexcept {
+        size_t retval = 0;
+        for (size_t rule = 0; rule < identifier && rule < rules; ++rule)
+            retval += looked_up(rule, identifier);
+        return retval;
+    }
+
+    static constexpr size_t power_of_two(size_t at_least) noexcept {
+        size_t retval = 1;
+        while (retval < at_least) retval *= 2;
+        return retval;
+    }
+    /**
+     * @brief A perfect hash (hash and displace) of the keywords of one identifier. The keywords
+     * are split into buckets by the hash, each bucket has a displacement chosen so that its
+     * keywords land in slots no other keyword does.
+     *
+     * @tparam Keywords the number of keywords.
+     */
+    template<size_t Keywords>
+    struct hash_table_t
+    {
+        static constexpr size_t slots = power_of_two(2 * Keywords + 2);
+        static constexpr size_t buckets = power_of_two(Keywords / 2 + 1);
+        static constexpr size_t slot_bits = __builtin_ctzll(slots);
+
+        uint16_t         displacement[buckets]{};
+        std::string_view text[slots]{};
+        size_t           rule[slots]{};
+        bool             complete{true};
+
+        static constexpr size_t bucket(uint64_t hash) noexcept {
+            return (hash >> 32) & (buckets - 1);
+        }
+
+        static constexpr size_t slot(uint64_t hash, uint64_t displacement) noexcept {
+            return ((hash ^ (displacement * 0x9e3779b97f4a7c15ull)) * 0xc2b2ae3d27d4eb4full)
+                   >> (64 - slot_bits);
+        }
+    };
+
+    template<size_t Identifier>
+    static constexpr auto make_hash_table() noexcept {
+        constexpr size_t count = keyword_count(Identifier);
+        using table_t = hash_table_t<count>;
+
+        table_t retval{};
+        // the views are assigned explicitly, GCC won't read value initialized ones at compile time.
+        for (size_t slot = 0; slot < table_t::slots; ++slot) {
+            retval.rule[slot] = none;
+            retval.text[slot] = std::string_view{};
+        }
+
+        size_t   keywords[count]{};
+        uint64_t hashes[count]{};
+        size_t   bucket_sizes[table_t::buckets]{};
+        for (size_t rule = 0, i = 0; rule < Identifier; ++rule) {
+            if (!looked_up(rule, Identifier)) continue;
+
+            keywords[i] = rule;
+            hashes[i] = hash_lexeme(m_literals[rule]);
+            ++bucket_sizes[table_t::bucket(hashes[i++])];
+        }
+        // the biggest buckets are the hardest to place, so they go first.
+        for (size_t size = count; size > 0; --size) {
+            for (size_t bucket = 0; bucket < table_t::buckets; ++bucket) {
+                if (bucket_sizes[bucket] != size) continue;
+
+                bool placed = false;
+                for (uint64_t displacement = 0; displacement <= 0xffff && !placed; ++displacement) {
+                    size_t taken[count]{};
+                    size_t taken_count = 0;
+                    placed = true;
+                    for (size_t i = 0; i < count && placed; ++i) {
+                        if (table_t::bucket(hashes[i]) != bucket) continue;
+
+                        auto slot = table_t::slot(hashes[i], displacement);
+                        for (size_t j = 0; j < taken_count && placed; ++j)
+                            placed = taken[j] != slot;
+                        placed = placed && retval.rule[slot] == none;
+                        taken[taken_count++] = slot;
+                    }
+
+                    if (!placed) continue;
+
+                    retval.displacement[bucket] = static_cast<uint16_t>(displacement);
+                    for (size_t i = 0; i < count; ++i) {
+                        if (table_t::bucket(hashes[i]) != bucket) continue;
+
+                        auto slot = table_t::slot(hashes[i], displacement);
+                        retval.rule[slot] = keywords[i];
+                        retval.text[slot] = m_literals[keywords[i]];
+                    }
+                }
+                retval.complete = retval.complete && placed;
+            }
+        }
+        return retval;
+    }
+
+    template<size_t Identifier>
+    struct hash_table_of
+    {
+        static constexpr auto value = make_hash_table<Identifier>();
+    };
+
+public:
+    /** @brief whether the rule is a keyword which is never matched on its own. */
+    static constexpr bool absorbed(size_t rule) noexcept {
+        return rule < rules && m_absorbed[rule] != none;
+    }
+    /** @brief whether keywords have to be looked up after the rule matches. */
+    static constexpr bool has_keywords(size_t rule) noexcept { return keyword_count(rule) > 0; }
+    /**
+     * @brief finds the keyword a lexeme matched by an identifier is.
+     *
+     * @tparam Identifier the index of the identifier rule.
+     * @param lexeme the text the identifier matched.
+     * @return size_t the index of the keyword rule or none if the lexeme is no keyword.
+     */
+    template<size_t Identifier>
+    static constexpr size_t find(std::string_view lexeme) noexcept {
+        return find<Identifier>(lexeme, hash_lexeme(lexeme));
+    }
+    /**
+     * @brief finds the keyword a lexeme matched by an identifier is, by its hash computed already
+     * (which is kept with the match, see ctle::lexer::lexeme_hash).
+     *
+     * @param hash hash_lexeme of the lexeme.
+     */
+    template<size_t Identifier>
+    static constexpr size_t find(std::string_view lexeme, uint64_t hash) noexcept {
+        constexpr auto& table = hash_table_of<Identifier>::value;
+        static_assert(table.complete, "Couldn't build a perfect hash of the keywords.");
+
+        auto slot = table.slot(hash, table.displacement[table.bucket(hash)]);
+        return table.text[slot] == lexeme ? table.rule[slot] : none;
+    }
+};
+} // namespace ctle
+#endif // CTLE_KEYWORDS
@@ -2,13 +2,22 @@
 #define CTLE_LEXER
 
 #include "match_result.h"
+#include "matchers.h"
+#include "dfa.h"
+#include "dispatch.h"
+#include "keywords.h"
+#include "scan.h"
 #include "rule_filters.h"
 #include "utils.h"
 #include "action.h"
 #include "extensions.h"
 #include "states.h"
+#include "token.h"
 
+#include <limits>
 #include <optional>
+#include <stdexcept>
+#include <utility>
 
 namespace ctle {
 /**
@@ -20,12 +29,14 @@ namespace ctle {
  * @tparam Actions an instance of ctle::actions, these are the actions used in the initial state,
  * which is not user defined by itself but its actions can be.
  * @tparam IteratorT a ForwardIterator.
+ * @tparam Matcher the way rules of a state are matched, ctle::fold_matcher or ctle::dfa_matcher.
  */
 template<typename ReturnT, typename Rules, typename States = states<>,
          typename Extensions = extensions<>, typename Actions = defaults<ReturnT>,
-         typename IteratorT = const char*>
+         typename IteratorT = const char*, typename Matcher = fold_matcher>
 class lexer
-  : public Extensions::template inner<lexer<Rules, States, Extensions, Actions, IteratorT>>
+  : public Extensions::template inner<
+      lexer<ReturnT, Rules, States, Extensions, Actions, IteratorT, Matcher>>
 {
     /**@brief The return type of rules (and of lex() function implicitly). */
     using rule_return_t = ReturnT;
@@ -45,20 +56,47 @@ class lexer
     using return_t = std::tuple<rule_return_t, string_view_t>;
     /**
      * @brief The internal return type used in match function, the optional signals whether to
-     * return or not and the string view is the lexeme.
+     * return or not, the string view is the lexeme and the size_t its offset (see offset_of).
      */
-    using match_return_t = std::tuple<std::optional<rule_return_t>, string_view_t>;
-    /** @brief prototype of a match function as one is generated for each state. */
-    using match_signature_t = match_return_t (lexer::*)();
-    /**
-     * @brief Represents a state-function pair, the state is the identifier and the function is its
-     * match function.
-     */
-    using state_function_pair_t = std::pair<int, match_signature_t>;
-    /** @brief current matching function (switched when state is switched). */
-    match_signature_t current_match_function{nullptr};
+    using match_return_t = std::tuple<std::optional<rule_return_t>, string_view_t, size_t>;
+    /** @brief gets the definitions of all states, the initial one first. */
+    template<typename... StateDefinition>
+    static auto make_state_definitions(ctll::list<StateDefinition...>)
+      -> std::tuple<state<state_initial, true, Actions>, StateDefinition...>;
+    /** @brief The definitions of states, states are indexed by their position in it. */
+    using state_definitions_t = decltype(make_state_definitions(state_list()));
+    /** @brief The number of states. */
+    static constexpr size_t state_count = std::tuple_size_v<state_definitions_t>;
+    /** @brief The index of the current state (switched when state is switched). */
+    size_t m_state{0};
     /** @brief The current range we're lexing. */
     input_range_t m_input{};
+    /** @brief The beginning of the input, offsets of tokens are relative to it. */
+    IteratorT m_input_base{};
+    /** @brief The offset of m_input_base, a streamed input drops what was lexed already. */
+    size_t m_input_offset{0};
+    /**
+     * @brief refills a streamed input (waiting for it or not) and updates the input range, see
+     * set_input, true if something was read.
+     */
+    bool (*m_refill)(lexer&, bool wait) noexcept {nullptr};
+    /** @brief The streamed input, nullptr if the input is not streamed. */
+    void* m_stream{nullptr};
+    /** @brief a streamed input is refilled once lexing reaches this position. */
+    IteratorT m_refill_at{};
+    /** @brief releases the pages of a mapped input before an offset, see set_input. */
+    void (*m_release)(lexer&, size_t offset) noexcept {nullptr};
+    /** @brief The input releasing pages, nullptr if it doesn't. */
+    void* m_releasing{nullptr};
+    /**
+     * @brief incremented whenever the characters of the input may move (another input is set, a
+     * streamed input drops what was lexed), checkpoints of an older one are rejected.
+     */
+    size_t m_generation{0};
+    /** @brief hash_lexeme of the last lexeme if looking up keywords computed it, 0 otherwise. */
+    uint64_t m_lexeme_hash{0};
+    /** @brief the beginning of the last lexeme, it ends where the input begins. */
+    IteratorT m_lexeme_begin{};
     /**
      * @brief a function representing no action, just returns an empty optional.
      *
@@ -79,12 +117,17 @@ class lexer
     using action_signature_t = std::optional<rule_return_t> (*)(lexer&, storage_t&&);
     /** @brief The type wihich encapsulates the storage and an action attached to it. */
     using match_result_t = match_result<storage_t, action_signature_t>;
+    /** @brief a match function trying only some of the rules of a state. */
+    using candidates_match_t = match_result_t (*)(input_range_t);
+    /** @brief whether captures are only matched for the rule which won, see ctle::two_phase. */
+    static constexpr bool recognize_first = requires { Matcher::recognize_first; };
     /**
      * @brief an implementation of a rule within the lexer.
      *
      * @tparam Rule a ctle::rule in which the provided data is stored.
+     * @tparam Index the index of the rule in its state, lower wins if two rules match equally long.
      */
-    template<typename Rule>
+    template<typename Rule, size_t Index>
     class rule
     {
         /** @brief calls the match function of the ctle::rule. */
@@ -93,6 +136,8 @@ class lexer
         }
         /** @brief the type of result returned by match in the rule. */
         using result_t = decltype(match_pattern(std::declval<input_range_t>()));
+        /** @brief whether the rule is matched by scanning the input, see ctle::skip_shape_of. */
+        static constexpr bool skips = Rule::skip_shape_t::value && is_char_pointer<IteratorT>;
         /**
          * @brief a wrapper around an actual call to the action. This way we can get function
          * pointers to lambdas with captures etc. This call knows how many elements from storage it
@@ -107,6 +152,8 @@ class lexer
             return apply_tuple<action<tmp, rule_return_t>{}, std::tuple_size_v<result_t>>(
               std::move(p), l);
         }
+
+    public:
         /**
          * @brief gets the correct pointer to a function. If rule has action, returns a pointer
          * to function executing said action. If not returns a potiner to a function that just
@@ -120,8 +167,6 @@ class lexer
             else
                 return &action_impl;
         }
-
-    public:
         /**
          * @brief tries to match the input to the provided rule.
          *
@@ -130,10 +175,31 @@ class lexer
          * @return auto a match_result, containing a match and an action.
          */
         static CTLL_FORCE_INLINE auto match(input_range_t input) {
-            return match_result_t{match_pattern(input), get_action()};
+            if constexpr (skips) {
+                auto end = Rule::skip_shape_t::match(input.begin, input.end);
+                return match_result_t{string_view_t(input.begin, end - input.begin), get_action(),
+                                      Index};
+            } else {
+                return match_result_t{match_pattern(input), get_action(), Index};
+            }
         }
         /**@brief the return type of calling match. */
         using return_t = decltype(match(std::declval<input_range_t>()));
+        /** @brief whether the rule has any captures. */
+        static constexpr bool has_captures = std::tuple_size_v<result_t> > 1;
+        /**
+         * @brief tries to match the input the way candidates are matched, without captures if
+         * the matcher recognizes first (they are added by match once the rule wins).
+         *
+         * @param input the scanned range.
+         * @return auto a match_result, containing a match and an action.
+         */
+        static CTLL_FORCE_INLINE auto attempt(input_range_t input) {
+            if constexpr (recognize_first && has_captures)
+                return match_result_t{Rule::recognize(input.begin, input.end), get_action(), Index};
+            else
+                return match(input);
+        }
     };
 
 public:
@@ -147,13 +213,10 @@ public:
      * @return false if no such state exists.
      */
     bool set_state(int state) noexcept {
-        auto it = std::lower_bound(m_state_functions.cbegin(), m_state_functions.cend(),
-                                   state_function_pair_t{state, nullptr},
-                                   [](const auto& a, const auto& b) { return a.first < b.first; });
-
-        if (it == m_state_functions.cend() || it->first != state) return false;
+        auto index = state_index(state, std::make_index_sequence<state_count>());
+        if (index == state_count) return false;
 
-        current_match_function = it->second;
+        m_state = index;
         return true;
     }
     /**
@@ -164,42 +227,246 @@ public:
      * @return false if no such state exists.
      */
     bool set_state(state_t state) noexcept { return set_state(static_cast<int>(state)); }
+    /**
+     * @brief Get the state of lexer.
+     *
+     * @return int the identifier of the current state.
+     */
+    int get_state() const noexcept { return m_state_identifiers[m_state]; }
+    /**
+     * @brief Set the state of lexer, the state is looked up at compile time.
+     *
+     * @tparam State state to be set, must exist.
+     */
+    template<auto State>
+    void set_state() noexcept {
+        constexpr auto index
+          = state_index(static_cast<int>(State), std::make_index_sequence<state_count>());
+        static_assert(index != state_count, "No such state exists.");
+
+        m_state = index;
+    }
     /**
      * @brief tells lexer to match another rule
      *
      * @return return_t return of the first rule which has action that returns.
      */
     return_t lex() {
-        while (true) {
-            if (auto [retval, lexeme] = (this->*current_match_function)(); retval)
-                return {std::move(retval.value()), lexeme};
-        }
+        size_t offset;
+        return lex(offset);
+    }
+    /**
+     * @brief tells lexer to match another rule, the lexeme is returned as an offset and length.
+     *
+     * @return compact_token<rule_return_t> return of the first rule which has action that returns.
+     * @throws std::length_error if the token lies beyond 4 GiB of input.
+     */
+    compact_token<rule_return_t> lex_compact() {
+        size_t offset;
+        auto [token, lexeme] = lex(offset);
+
+        if (offset + lexeme.size() > std::numeric_limits<uint32_t>::max())
+            [[unlikely]] throw std::length_error("Token offset doesn't fit a compact token.");
+
+        return compact_token<rule_return_t>{std::move(token), static_cast<uint32_t>(offset),
+                                            static_cast<uint32_t>(lexeme.size())};
+    }
+    /**
+     * @brief lexes tokens into columns, without returning after each of them. Stops when the
+     * columns are full, after the token returned at the end of input or when no rule matches (its
+     * lexeme is empty), a state changed by an action is lexed on in.
+     *
+     * @param columns arrays the tokens are stored to.
+     * @return size_t the number of tokens stored, 0 only once the input ends or no rule matches.
+     */
+    size_t lex_batch(token_columns<rule_return_t> columns) {
+        size_t retval = 0;
+        for (bool switched = true; switched;)
+            visit_state(
+              [&](auto state) { switched = this->template batch_in<state()>(columns, retval); });
+        return retval;
+    }
+    /**
+     * @brief tells that the characters before an offset, e.g. lexemes of tokens already processed,
+     * are no longer needed, so that an input providing release_before (such as ctle::basic_file)
+     * releases their pages right away and resident memory stays bounded, whichever way it's lexed
+     * (lex, lex_compact or lex_batch). Cheap unless a whole page is to be released, so it can be
+     * called after every batch of tokens.
+     *
+     * @param offset the offset of the first character still needed, from the beginning of the input.
+     */
+    void release_before(size_t offset) noexcept {
+        if (m_release) m_release(*this, offset);
     }
     /**
      * @brief Set the input.
      *
      * @param args Constor arguments for the input range.
      */
-    void set_input(const auto& input) { m_input = input_range_t{input.begin(), input.end()}; }
+    void set_input(const auto& input) {
+        m_input = input_range_t{input.begin(), input.end()};
+        m_input_base = m_input.begin;
+        m_input_offset = 0;
+        m_refill = nullptr;
+        m_stream = nullptr;
+        m_refill_at = m_input.end;
+        m_release = nullptr;
+        m_releasing = nullptr;
+        ++m_generation;
+    }
+    /**
+     * @brief Set an input which releases pages behind a watermark (such as ctle::basic_file), see
+     * release_before. The input must outlive the lexing.
+     *
+     * @param input the input, provides release_before(offset).
+     */
+    template<typename InputT>
+    requires requires(InputT& input, size_t offset) { input.release_before(offset); }
+    void set_input(InputT& input) {
+        set_input(std::as_const(input));
+        m_releasing = &input;
+        m_release = [](lexer& self, size_t offset) noexcept {
+            static_cast<InputT*>(self.m_releasing)->release_before(offset);
+        };
+    }
+    /**
+     * @brief Set the input and resume lexing it at a position, offsets stay from its beginning.
+     *
+     * @param input the input, provides begin() and end().
+     * @param position the position to lex from, within the input.
+     */
+    void set_input(const auto& input, IteratorT position) {
+        set_input(input);
+        m_input.begin = position;
+    }
+    /**
+     * @brief Set a streamed input (such as ctle::basic_stream_input). Whenever half of its capacity
+     * or less is left to lex, it is refilled and waited for until more is left or the stream ends,
+     * so that a token (an open comment, a string literal, ...) up to that long isn't cut short by a
+     * pipe which has only a part of it yet, a non-blocking descriptor is lexed as far as it has
+     * data. Lexemes are valid until the next call to lex, the input must outlive the lexing. Eof is
+     * returned when the stream ends or has nothing yet (see its status), lexing again later reads
+     * on, e.g. once more is appended to a file.
+     *
+     * @param input the input, provides refill(keep, wait) dropping everything before keep.
+     */
+    template<typename StreamT>
+    requires requires(StreamT& stream, IteratorT keep) { stream.refill(keep, true); }
+    void set_input(StreamT& input) {
+        set_input(std::as_const(input));
+        m_stream = &input;
+        m_refill = [](lexer& self, bool wait) noexcept {
+            auto& stream = *static_cast<StreamT*>(self.m_stream);
+            auto  read_any = stream.refill(self.m_input.begin, wait);
+            // the characters kept moved to the front of the buffer.
+            if (stream.offset() != self.m_input_offset) ++self.m_generation;
+
+            self.m_input = input_range_t{stream.begin(), stream.end()};
+            self.m_input_base = self.m_input.begin;
+            self.m_input_offset = stream.offset();
+            // refill once half of the capacity or less is left (right away if no more is there
+            // yet), if nothing was read only once the end is reached.
+            auto ahead = std::min(stream.size(), stream.capacity() / 2);
+            self.m_refill_at = read_any ? self.m_input.end - ahead : self.m_input.end;
+            return read_any;
+        };
+        m_input = input_range_t{input.begin(), input.begin()};
+        m_refill(*this, false);
+    }
     /**
      * @brief Get the input range in its current state.
      *
      * @return input_range_t
      */
     input_range_t get_input() { return m_input; }
+    /**
+     * @brief hash_lexeme of a lexeme, taken from looking up keywords if it is the lexeme matched
+     * last (such as in the action of an identifier), computed otherwise.
+     *
+     * @param lexeme the lexeme.
+     * @return uint64_t its hash.
+     */
+    uint64_t lexeme_hash(string_view_t lexeme) const noexcept {
+        if constexpr (std::is_pointer_v<IteratorT>)
+            if (m_lexeme_hash && lexeme.data() == m_lexeme_begin
+                && lexeme.data() + lexeme.size() == m_input.begin)
+                return m_lexeme_hash;
+
+        return hash_lexeme(lexeme);
+    }
+    /**
+     * @brief A position of the lexer saved by checkpoint.
+     *
+     * @tparam ExtensionsT the saved states of extensions.
+     */
+    template<typename ExtensionsT>
+    struct checkpoint_t
+    {
+        input_range_t input;
+        IteratorT     input_base;
+        size_t        input_offset;
+        IteratorT     refill_at;
+        size_t        state;
+        size_t        generation;
+        ExtensionsT   extensions;
+    };
+    /**
+     * @brief saves the position in the input, the state and the states of extensions which opt in
+     * (see ctle::extensions), so that lexing can go back to it by restore (e.g. when a parser
+     * backtracks). It's valid until another input is set (also by an extension such as
+     * ctle::include_stack) or a streamed input drops what was lexed on a refill.
+     *
+     * @return checkpoint_t the saved position.
+     */
+    auto checkpoint() const {
+        using extensions_t = decltype(this->save_extensions());
+        return checkpoint_t<extensions_t>{m_input,   m_input_base, m_input_offset, m_refill_at,
+                                          m_state,   m_generation, this->save_extensions()};
+    }
+    /**
+     * @brief goes back to a position saved by checkpoint.
+     *
+     * @param checkpoint the saved position.
+     * @throws std::invalid_argument if the checkpoint is no longer valid, see checkpoint.
+     */
+    template<typename ExtensionsT>
+    void restore(const checkpoint_t<ExtensionsT>& checkpoint) {
+        if (checkpoint.generation != m_generation)
+            [[unlikely]] throw std::invalid_argument("The checkpoint is of another input.");
+
+        m_input = checkpoint.input;
+        m_input_base = checkpoint.input_base;
+        m_input_offset = checkpoint.input_offset;
+        m_refill_at = checkpoint.refill_at;
+        m_state = checkpoint.state;
+        this->restore_extensions(checkpoint.extensions);
+    }
 
 private:
+    /** @brief the offset of a position from the beginning of the input. */
+    size_t offset_of(IteratorT position) const noexcept {
+        return m_input_offset + static_cast<size_t>(std::distance(m_input_base, position));
+    }
+    /**
+     * @brief lets an extension providing on_eof (such as ctle::include_stack) continue with another
+     * input once the input ends.
+     *
+     * @return true if lexing continues, false if the eof action should run.
+     */
+    bool continue_after_eof() noexcept {
+        if constexpr (requires(lexer& self) { self.on_eof(); })
+            return this->on_eof();
+        else
+            return false;
+    }
     /**
-     * @brief create one pair of identifier/function
+     * @brief gets the eof and no_match actions of a state.
      *
      * @tparam State the ctle::state object.
-     * @return assert_start wheter or not to assert the start of user defined states.
+     * @return ctle::actions the actions, where the state specifies none those of initial state.
      */
-    template<typename State, bool assert_start = true>
-    static constexpr auto make_state_function_pair() {
-        if constexpr (assert_start)
-            static_assert(State::identifier() >= state_reserved,
-                          "All states must begin at state_reserved.");
+    template<typename State>
+    static constexpr auto make_local_actions() {
         // the next four statements are there to not ICE gcc.
         // get the eof action for this state (if none specified uses the one for initial state).
         constexpr auto chosen_eof
@@ -210,31 +477,108 @@ private:
         constexpr auto chosen_no_match
           = callable_utils::get_default<State::actions::no_match, Actions::no_match>();
         constexpr auto no_match_action = action<chosen_no_match, rule_return_t>{};
-        // take pointer to a method with a filtered set of rules.
-        constexpr match_signature_t function_ptr = &lexer::match_impl<
-          actions<eof_action, no_match_action>,
-          typename state_filter<State, state_initial>::template filtered_t<rule_list>>;
-        // add this matching function to array of all matching functions.
-        return state_function_pair_t{State::identifier(), function_ptr};
-    }
-    /** @brief creates matching functions for all states and sorts them by identifiers. */
-    template<typename... StateDefinition>
-    static constexpr auto make_state_functions(ctll::list<StateDefinition...>) {
-        std::array retval{make_state_function_pair<state<state_initial, true, Actions>, false>(),
-                          make_state_function_pair<StateDefinition>()...};
-
-        sort(retval, [](const auto& a, const auto& b) { return a.first < b.first; });
+        return actions<eof_action, no_match_action>{};
+    }
+    /** @brief the eof and no_match actions of a state. */
+    template<size_t State>
+    using local_actions_t
+      = decltype(make_local_actions<std::tuple_element_t<State, state_definitions_t>>());
+    /** @brief the rules of a state. */
+    template<size_t State>
+    using state_rules_t = typename state_filter<std::tuple_element_t<State, state_definitions_t>,
+                                                state_initial>::template filtered_t<rule_list>;
+    /** @brief creates an array of identifiers of states, indexed like states. */
+    template<typename Initial, typename... StateDefinition>
+    static constexpr auto make_state_identifiers(std::tuple<Initial, StateDefinition...>*) {
+        static_assert(((static_cast<int>(StateDefinition::identifier()) >= state_reserved) && ...),
+                      "All states must begin at state_reserved.");
 
+        return std::array{static_cast<int>(Initial::identifier()),
+                          static_cast<int>(StateDefinition::identifier())...};
+    }
+    /**
+     * @brief finds the index of a state.
+     *
+     * @param state the identifier of the state.
+     * @return size_t the index of the state or state_count if no such state exists.
+     */
+    template<size_t... Index>
+    static constexpr size_t state_index(int state, std::index_sequence<Index...>) noexcept {
+        size_t retval = state_count;
+        // compared against constants, so this ends up as a switch.
+        (void)((state == m_state_identifiers[Index] && (retval = Index, true)) || ...);
         return retval;
     }
     /**
-     * @brief the function from which the matching functions are generated.
+     * @brief calls the function with the index of the current state as an std::integral_constant,
+     * so that everything done in the state can be inlined into it.
+     */
+    template<typename Function, size_t... Index>
+    CTLL_FORCE_INLINE void visit_state(Function&& function, std::index_sequence<Index...>) {
+        (void)((m_state == Index && (function(std::integral_constant<size_t, Index>{}), true))
+               || ...);
+    }
+
+    template<typename Function>
+    CTLL_FORCE_INLINE void visit_state(Function&& function) {
+        visit_state(std::forward<Function>(function), std::make_index_sequence<state_count>());
+    }
+    /**
+     * @brief lexes the next token, see lex().
      *
-     * @see match.
+     * @param offset set to the offset of the lexeme, from the beginning of the input it's in.
      */
-    template<typename LocalActions, typename filtered_rules>
-    match_return_t match_impl() {
-        return match<LocalActions>(filtered_rules());
+    return_t lex(size_t& offset) {
+        std::optional<return_t> retval;
+        while (!retval)
+            visit_state([&](auto state) { retval = this->template lex_in<state()>(offset); });
+
+        return std::move(retval.value());
+    }
+    /**
+     * @brief matches in a state until a rule returns or the state changes.
+     *
+     * @tparam State the index of the state.
+     * @param offset set to the offset of the lexeme returned.
+     * @return std::optional<return_t> the token, empty if the state changed before any returned.
+     */
+    template<size_t State>
+    std::optional<return_t> lex_in(size_t& offset) {
+        do {
+            auto [retval, lexeme, lexeme_offset]
+              = match<local_actions_t<State>>(state_rules_t<State>());
+            if (retval) {
+                offset = lexeme_offset;
+                return return_t{std::move(retval.value()), lexeme};
+            }
+        } while (m_state == State);
+
+        return std::nullopt;
+    }
+    /**
+     * @brief lexes tokens of a state into columns.
+     *
+     * @tparam State the index of the state.
+     * @param count the number of tokens stored so far, incremented by those stored.
+     * @return true if the state changed and lexing goes on in the new one, false otherwise.
+     * @see lex_batch.
+     */
+    template<size_t State>
+    bool batch_in(token_columns<rule_return_t> columns, size_t& count) {
+        while (count < columns.capacity) {
+            auto [retval, lexeme, offset] = match<local_actions_t<State>>(state_rules_t<State>());
+            if (retval) {
+                columns.kinds[count] = std::move(retval.value());
+                columns.offsets[count] = offset;
+                columns.lengths[count] = lexeme.size();
+                ++count;
+            }
+            // the input doesn't move anymore (eof or no match).
+            if (lexeme.empty()) return false;
+            // other rules apply now.
+            if (m_state != State) return true;
+        }
+        return false;
     }
     /**
      * @brief real match function, uses fold statement to match all rules. Also moves input
@@ -256,21 +600,250 @@ private:
      */
     template<typename LocalActions, typename... Rule>
     CTLL_FORCE_INLINE match_return_t match(ctll::list<Rule...>) noexcept {
-        // handle eof
-        if (m_input.begin == m_input.end)
-            [[unlikely]] return match_return_t{LocalActions::eof(*this), string_view_t{}};
+        // keep enough of a streamed input ahead, so that tokens don't reach its end, waiting for it
+        // until the stream has nothing more.
+        if constexpr (std::is_pointer_v<IteratorT>)
+            if (m_input.begin >= m_refill_at && m_refill) [[unlikely]]
+                while (m_refill(*this, true) && m_input.begin >= m_refill_at) {}
+        // handle eof, unless an extension continues with another input.
+        while (m_input.begin == m_input.end) [[unlikely]]
+            if (!continue_after_eof())
+                return match_return_t{LocalActions::eof(*this), string_view_t{},
+                                      offset_of(m_input.begin)};
         // try to match
-        auto result = (match_result_t{nullptr} | ... | rule<Rule>::match(m_input));
+        auto result = match_rules(ctll::list<Rule...>(), std::index_sequence_for<Rule...>());
+        // a match reaching the end of a streamed input may go on after it, refilling moves what is
+        // kept to the front of the buffer even if nothing more was read.
+        if constexpr (std::is_pointer_v<IteratorT>)
+            while (m_refill && result.length() == static_cast<size_t>(m_input.end - m_input.begin)) {
+                auto read_any = m_refill(*this, true);
+                result = match_rules(ctll::list<Rule...>(), std::index_sequence_for<Rule...>());
+                if (!read_any) break;
+            }
         // hadnle no_match
         if (!result.length())
-            [[unlikely]] return match_return_t{LocalActions::no_match(*this), string_view_t{}};
+            [[unlikely]] return match_return_t{LocalActions::no_match(*this), string_view_t{},
+                                               offset_of(m_input.begin)};
+        // get the captures of the winner.
+        if constexpr (recognize_first)
+            result = capture_winner(ctll::list<Rule...>(), std::index_sequence_for<Rule...>(),
+                                    std::move(result));
         // advance iterator in read stream (file)
+        m_lexeme_begin = m_input.begin;
+        m_lexeme_hash = result.hash();
+        // before the action, which may switch to another input (see ctle::include_stack).
+        auto offset = offset_of(m_input.begin);
         std::advance(m_input.begin, result.length());
         // handle matched rule w/o action.
-        return match_return_t{result.do_action(*this), result.to_view()};
+        auto retval = result.do_action(*this);
+        return match_return_t{std::move(retval), result.to_view(), offset};
+    }
+    /**
+     * @brief matches all rules of a state on the current input, the way specified by Matcher.
+     *
+     * @tparam Rule A pack of rules.
+     * @tparam Index indices of the rules.
+     * @return match_result_t the longest match, if more are equally long, the first rule's one.
+     */
+    template<typename... Rule, size_t... Index>
+    CTLL_FORCE_INLINE match_result_t match_rules(ctll::list<Rule...> rules,
+                                                 std::index_sequence<Index...> indices) noexcept {
+        if constexpr (std::is_base_of_v<fold_matcher, Matcher>) {
+            using keywords_t = keywords_for<typename Rule::pattern_t::ast_t...>;
+            // keywords are looked up after their identifier matched.
+            constexpr std::array<bool, sizeof...(Rule)> enabled{!keywords_t::absorbed(Index)...};
+            return match_dispatched<keywords_t, enabled>(rules, indices);
+        } else {
+            using automaton_t
+              = dfa::automaton<Matcher::max_states, typename Rule::pattern_t::ast_t...>;
+
+            auto result = match_result_t{nullptr};
+            if constexpr (!automaton_t::empty()) {
+                static constexpr auto rule_actions = make_rule_actions(rules);
+
+                if (auto [length, index] = automaton_t::match(m_input.begin, m_input.end); length)
+                    result = match_result_t{string_view_t{&*m_input.begin, length},
+                                            rule_actions[index], index};
+            }
+            // rules which are not a part of the automaton are matched one by one.
+            constexpr std::array<bool, sizeof...(Rule)> uncompiled{
+              !automaton_t::compiled(Index)...};
+            if constexpr ((false || ... || uncompiled[Index]))
+                result = result | match_dispatched<keyword_table<>, uncompiled>(rules, indices);
+            return result;
+        }
+    }
+    /**
+     * @brief matches the rule which won again, with its captures this time.
+     *
+     * @tparam Rule A pack of rules.
+     * @tparam Index indices of the rules.
+     * @param winner the match of the rule which won, without captures.
+     * @return match_result_t the match with captures.
+     */
+    template<typename... Rule, size_t... Index>
+    CTLL_FORCE_INLINE match_result_t capture_winner(ctll::list<Rule...>,
+                                                    std::index_sequence<Index...>,
+                                                    match_result_t winner) noexcept {
+        static constexpr candidates_match_t capturing[]{
+          (rule<Rule, Index>::has_captures ? &rule<Rule, Index>::match : nullptr)..., nullptr};
+
+        if (auto function = capturing[winner.index()]; function) return function(m_input);
+        return winner;
+    }
+    /**
+     * @brief the keyword_table used for rules of a state, an empty one if lexemes aren't chars.
+     */
+    template<typename... Pattern>
+    using keywords_for = std::conditional_t<std::is_same_v<char_t, char>,
+                                            keyword_table<Pattern...>, keyword_table<>>;
+    /**
+     * @brief the actions of a list of rules, by their indices.
+     */
+    template<typename... Rule>
+    static constexpr auto make_rule_actions(ctll::list<Rule...>) {
+        return make_rule_actions(ctll::list<Rule...>(), std::index_sequence_for<Rule...>());
+    }
+
+    template<typename... Rule, size_t... Index>
+    static constexpr auto make_rule_actions(ctll::list<Rule...>, std::index_sequence<Index...>) {
+        return std::array<action_signature_t, sizeof...(Rule)>{rule<Rule, Index>::get_action()...};
+    }
+    /**
+     * @brief matches the enabled rules which can start with the first byte of the input, the rules
+     * that can are looked up in a ctle::first_byte_table.
+     *
+     * @tparam Keywords the ctle::keyword_table of the rules.
+     * @tparam Enabled for each rule whether to match it at all.
+     * @tparam Rule A pack of rules.
+     * @tparam Index indices of the rules.
+     */
+    template<typename Keywords, auto Enabled, typename... Rule, size_t... Index>
+    CTLL_FORCE_INLINE match_result_t
+      match_dispatched(ctll::list<Rule...> rules, std::index_sequence<Index...> indices) noexcept {
+        using table_t = first_byte_table<typename Rule::pattern_t::ast_t...>;
+        // wider characters don't fit the table, a single class makes it useless.
+        if constexpr (sizeof(char_t) != 1 || table_t::classes() == 1) {
+            return match_candidates<Keywords, Enabled>(m_input, rules, indices);
+        } else {
+            static constexpr auto functions
+              = make_candidates_functions<table_t, Keywords, Enabled, ctll::list<Rule...>,
+                                          std::index_sequence<Index...>>(
+                std::make_index_sequence<table_t::classes()>());
+
+            return functions[table_t::byte_class(static_cast<uint8_t>(*m_input.begin))](m_input);
+        }
+    }
+    /** @brief creates a match function for each class of a ctle::first_byte_table. */
+    template<typename Table, typename Keywords, auto Enabled, typename List, typename Indices,
+             size_t... Class>
+    static constexpr auto make_candidates_functions(std::index_sequence<Class...>) {
+        return std::array<candidates_match_t, sizeof...(Class)>{
+          &lexer::match_candidates<Keywords, enabled_candidates<Table, Enabled>(Class), List,
+                                   Indices>...};
+    }
+    /** @brief the rules which are both enabled and can start with a byte of the class. */
+    template<typename Table, auto Enabled>
+    static constexpr auto enabled_candidates(size_t byte_class) {
+        auto retval = Table::candidates(byte_class);
+        for (size_t i = 0; i < retval.size(); ++i) retval[i] = retval[i] && Enabled[i];
+        return retval;
+    }
+    /** @brief matches the candidate rules, in a form usable as a function pointer. */
+    template<typename Keywords, auto Candidates, typename List, typename Indices>
+    static match_result_t match_candidates(input_range_t input) noexcept {
+        return match_candidates<Keywords, Candidates>(input, List(), Indices());
+    }
+    /**
+     * @brief matches the candidate rules one by one.
+     *
+     * @tparam Keywords the ctle::keyword_table of the rules.
+     * @tparam Candidates for each rule whether to match it.
+     * @tparam Rule A pack of rules.
+     * @tparam Index indices of the rules.
+     */
+    template<typename Keywords, auto Candidates, typename... Rule, size_t... Index>
+    static CTLL_FORCE_INLINE match_result_t
+      match_candidates(input_range_t input, ctll::list<Rule...>,
+                       std::index_sequence<Index...>) noexcept {
+        using list_t = ctll::list<Rule...>;
+        using rules_t = std::tuple<Rule...>;
+        // rules which can match longer texts go first, so that the others can be skipped.
+        constexpr auto order = longest_first(list_t());
+
+        auto result = match_result_t{nullptr};
+        ((result = match_candidate<Keywords, list_t, Candidates[order[Index]],
+                                   std::tuple_element_t<order[Index], rules_t>, order[Index]>(
+            input, result)),
+         ...);
+        return result;
+    }
+    /**
+     * @brief orders rules by the maximal length of their match, the longest first. Rules of the
+     * same maximal length keep their order.
+     *
+     * @return std::array<size_t, N> indices of the rules in that order.
+     */
+    template<typename... Rule>
+    static constexpr auto longest_first(ctll::list<Rule...>) {
+        constexpr size_t lengths[]{max_length_of<typename Rule::pattern_t::ast_t>::value()..., 0};
+
+        std::array<size_t, sizeof...(Rule)> retval{};
+        for (size_t i = 0; i < retval.size(); ++i) {
+            auto position = i;
+            for (; position > 0 && lengths[retval[position - 1]] < lengths[i]; --position)
+                retval[position] = retval[position - 1];
+            retval[position] = i;
+        }
+        return retval;
+    }
+    /**
+     * @brief matches a rule if it is a candidate and it can beat the best match so far (its match
+     * can be longer or as long but it is specified earlier). If it is an identifier with keywords,
+     * its result becomes the keyword's one if it matched a keyword.
+     *
+     * @tparam Keywords the ctle::keyword_table of the rules.
+     * @tparam List all rules of the state.
+     * @tparam Candidate whether to match the rule (otherwise nothing is done).
+     * @tparam Rule the rule.
+     * @tparam Index its index.
+     * @param best the best match so far.
+     * @return match_result_t the better of best and the match of the rule.
+     */
+    template<typename Keywords, typename List, bool Candidate, typename Rule, size_t Index>
+    static CTLL_FORCE_INLINE match_result_t match_candidate(input_range_t  input,
+                                                            match_result_t best) noexcept {
+        constexpr auto max_length = max_length_of<typename Rule::pattern_t::ast_t>::value();
+
+        if constexpr (!Candidate) {
+            return best;
+        } else {
+            if (max_length < best.length() || (max_length == best.length() && Index > best.index()))
+                return best;
+
+            if constexpr (Keywords::has_keywords(Index)) {
+                auto result = rule<Rule, Index>::attempt(input);
+                // a keyword is as long, an identifier shorter than the best match can't win.
+                if (!result.length() || result.length() < best.length()) return best;
+                // a second pass over the identifier, kept with the result so that the action
+                // doesn't hash it again.
+                auto hash = hash_lexeme(result.to_view());
+                if (auto keyword = Keywords::template find<Index>(result.to_view(), hash);
+                    keyword != Keywords::none) {
+                    static constexpr auto rule_actions = make_rule_actions(List());
+                    return best
+                           | match_result_t{result.to_view(), rule_actions[keyword], keyword}
+                               .with_hash(hash);
+                }
+                return best | std::move(result).with_hash(hash);
+            } else {
+                return best | rule<Rule, Index>::attempt(input);
+            }
+        }
     }
-    /** @brief an array holding a function pointer for each state (something like a vtable). */
-    static constexpr auto m_state_functions{make_state_functions(state_list())};
+    /** @brief an array holding the identifier of each state. */
+    static constexpr auto m_state_identifiers{
+      make_state_identifiers(static_cast<state_definitions_t*>(nullptr))};
 };
 
 } // namespace ctle
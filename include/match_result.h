@@ -6,6 +6,8 @@
 
 #include <tuple>
 #include <array>
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <ctll/utilities.hpp>
 
@@ -33,12 +35,21 @@ class match_result
      *
      */
     SigT m_action{nullptr};
+    /**
+     * @brief the index of the rule which produced this result, on equal lengths the rule specified
+     * first wins.
+     *
+     */
+    size_t m_index{std::numeric_limits<size_t>::max()};
+    /** @brief hash_lexeme of the matched text if looking up keywords computed it, 0 otherwise. */
+    uint64_t m_hash{0};
     /**
      * @brief Internal impl of ctor.
      */
     template<typename Ty, size_t... idx>
-    CTLL_FORCE_INLINE match_result(Ty&& data, SigT action, std::index_sequence<idx...>)
-      : m_results{data.template get<idx>()...}, m_action{action} {}
+    CTLL_FORCE_INLINE match_result(Ty&& data, SigT action, size_t index,
+                                   std::index_sequence<idx...>)
+      : m_results{data.template get<idx>()...}, m_action{action}, m_index{index} {}
 
 public:
     /**
@@ -48,10 +59,21 @@ public:
      * @tparam Ty
      * @param data a tuple-like object returned from rule::match.
      * @param action an action to be executed if this result is chosen as the matched one.
+     * @param index the index of the rule which matched.
      */
     template<typename Ty>
-    match_result(Ty&& data, SigT action)
-      : match_result(std::move(data), action, std::make_index_sequence<std::tuple_size_v<Ty>>()) {}
+    match_result(Ty&& data, SigT action, size_t index)
+      : match_result(std::move(data), action, index,
+                     std::make_index_sequence<std::tuple_size_v<Ty>>()) {}
+    /**
+     * @brief Construct a new match_result from just the matched text (rules without captures).
+     *
+     * @param lexeme the matched text.
+     * @param action an action to be executed if this result is chosen as the matched one.
+     * @param index the index of the rule which matched.
+     */
+    constexpr match_result(value_type lexeme, SigT action, size_t index)
+      : m_results{lexeme}, m_action{action}, m_index{index} {}
     /**
      * @brief Ctor for an empty result. The action shouldn't be executed if this is the case.
      *
@@ -81,13 +103,31 @@ public:
      * @return length of this result.
      */
     auto length() const noexcept { return to_view().length(); }
+    /**
+     * @brief returns the index of the rule which produced this result.
+     *
+     * @return the index, or the maximal value of size_t for an empty result.
+     */
+    size_t index() const noexcept { return m_index; }
+    /** @brief hash_lexeme of the matched text if it was computed, 0 otherwise. */
+    uint64_t hash() const noexcept { return m_hash; }
+    /**
+     * @brief keeps the hash of the matched text, computed while looking up keywords.
+     *
+     * @return match_result the result with the hash.
+     */
+    match_result with_hash(uint64_t hash) && noexcept {
+        m_hash = hash;
+        return std::move(*this);
+    }
     /**
      * @brief used in a fold expresion.
      *
      * @param other the result to compare to.
-     * @return the one that is longer.
+     * @return the one that is longer, on equal lengths the one of the rule specified first.
      */
     match_result operator|(match_result other) {
+        if (length() == other.length()) return (other.m_index < m_index) ? other : *this;
         return (length() < other.length()) ? other : *this;
     }
 };
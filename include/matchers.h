@@ -0,0 +1,45 @@
+#ifndef CTLE_MATCHERS
+#define CTLE_MATCHERS
+
+#include <cstddef>
+
+namespace ctle {
+/**
+ * @brief Matches the input by trying rules of the current state with CTRE, the longest match wins
+ * and on equal lengths the rule specified first. Rules which can't start with the first byte of
+ * the input (see ctle::first_byte_table) are skipped. Keywords whose matches an identifier rule
+ * matches too are looked up after the identifier instead (see ctle::keyword_table). Rules are
+ * tried from those with the longest possible match and the ones that can't beat the best match so
+ * far anymore are skipped.
+ */
+struct fold_matcher
+{};
+/**
+ * @brief Merges all rules of a state into one deterministic automaton at compile time, which reads
+ * every token just once and reports the longest match and the first rule accepting it. Rules whose
+ * CTRE match may be shorter than the longest one (alternations like a|ab, possessive repetitions
+ * like [a-z]*+[a-z] which don't give characters back, see ctle::first_match_is_longest) and rules
+ * using lazy repetitions, captures, anchors, lookaheads or backreferences aren't merged and are
+ * matched by CTRE, so tokens are the same as with fold_matcher.
+ *
+ * @tparam MaxStates maximal number of states of the automaton of one lexer state.
+ */
+template<size_t MaxStates = 1024>
+struct dfa_matcher
+{
+    static constexpr size_t max_states = MaxStates;
+};
+/**
+ * @brief Matches rules the way Matcher does, but without their captures first. Only the rule which
+ * wins is matched again to get its captures, so rules which lose don't record them. The winner is
+ * matched twice if it has captures, which pays off when such rules rarely win.
+ *
+ * @tparam Matcher ctle::fold_matcher or ctle::dfa_matcher.
+ */
+template<typename Matcher>
+struct two_phase : Matcher
+{
+    static constexpr bool recognize_first = true;
+};
+} // namespace ctle
+#endif // CTLE_MATCHERS
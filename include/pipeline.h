@@ -0,0 +1,214 @@
+#ifndef CTLE_PIPELINE
+#define CTLE_PIPELINE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace ctle {
+/** @brief the size of a cache line, members written by different threads are kept this apart. */
+constexpr size_t cache_line_size = 64;
+/**
+ * @brief A lock free queue of a fixed capacity between one producing and one consuming thread. The
+ * producer publishes pushed items in batches (or by publish), so that the consumer's cache line is
+ * not invalidated by every item, each side caches the index of the other and reads it again only
+ * when the queue looks full (empty).
+ *
+ * @tparam Ty the type of items, default constructible.
+ * @tparam Capacity the number of items, a power of two.
+ * @tparam Batch the number of items published at once.
+ */
+template<typename Ty, size_t Capacity, size_t Batch = 64>
+class spsc_ring
+{
+    static_assert(Capacity && !(Capacity & (Capacity - 1)), "The capacity must be a power of two.");
+    static_assert(Batch && Batch <= Capacity, "A batch must fit the capacity.");
+
+    // written by the consumer, read by the producer.
+    alignas(cache_line_size) std::atomic<size_t> m_head{0};
+    // written by the producer, read by the consumer.
+    alignas(cache_line_size) std::atomic<size_t> m_tail{0};
+    // the consumer's own.
+    alignas(cache_line_size) size_t m_known_tail{0};
+    // the producer's own.
+    alignas(cache_line_size) size_t m_pending_tail{0};
+    size_t m_known_head{0};
+
+    alignas(cache_line_size) std::array<Ty, Capacity> m_items{};
+
+public:
+    /**
+     * @brief adds an item, publishes the batch once it is full, producer only.
+     *
+     * @param item the item, moved from only if added.
+     * @return true if added, false if the queue is full (everything pending is published then).
+     */
+    bool try_push(Ty&& item) noexcept(std::is_nothrow_move_assignable_v<Ty>) {
+        if (m_pending_tail - m_known_head == Capacity) {
+            m_known_head = m_head.load(std::memory_order_acquire);
+            if (m_pending_tail - m_known_head == Capacity) {
+                publish();
+                return false;
+            }
+        }
+
+        m_items[m_pending_tail++ & (Capacity - 1)] = std::move(item);
+        if (m_pending_tail - m_tail.load(std::memory_order_relaxed) >= Batch) publish();
+        return true;
+    }
+    /** @brief makes the items pushed so far visible to the consumer, producer only. */
+    void publish() noexcept {
+        if (m_tail.load(std::memory_order_relaxed) != m_pending_tail)
+            m_tail.store(m_pending_tail, std::memory_order_release);
+    }
+    /**
+     * @brief takes items published, consumer only.
+     *
+     * @param items the array the items are moved to.
+     * @param count the size of the array.
+     * @return size_t the number of items taken, 0 if there were none.
+     */
+    size_t try_pop(Ty* items, size_t count) noexcept(std::is_nothrow_move_assignable_v<Ty>) {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_known_tail) {
+            m_known_tail = m_tail.load(std::memory_order_acquire);
+            if (head == m_known_tail) return 0;
+        }
+
+        count = std::min(count, m_known_tail - head);
+        for (size_t i = 0; i < count; ++i)
+            items[i] = std::move(m_items[(head + i) & (Capacity - 1)]);
+
+        m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+};
+/**
+ * @brief Lexes on a thread of its own, so that lexing and parsing overlap on separate cores. The
+ * tokens go through a ctle::spsc_ring, once it is full the lexing thread waits for the consumer to
+ * catch up. The tokens pushed are published before the next one is lexed, so that the consumer
+ * sees them while lexing waits (for a streamed input, ...). Either side spins shortly, then yields
+ * and then sleeps while it waits for the other. Lexemes stay valid as long as with lex, except for
+ * a streamed input.
+ *
+ * @tparam LexerT the type of the lexer, a ctle::lexer.
+ * @tparam Capacity the number of tokens the ring holds, a power of two.
+ */
+template<typename LexerT, size_t Capacity = 4096>
+class token_pipeline
+{
+public:
+    using token_t = decltype(std::declval<LexerT&>().lex());
+
+private:
+    spsc_ring<token_t, Capacity> m_ring;
+    // written by the producer once it's done, read by the consumer when the ring is empty.
+    alignas(cache_line_size) std::atomic<bool> m_finished{false};
+    std::exception_ptr m_error;
+    // written by the consumer to stop the producer early.
+    alignas(cache_line_size) std::atomic<bool> m_stopped{false};
+    std::thread m_producer;
+
+    /** @brief waits for the other thread, the longer the more often it was waited for. */
+    static void back_off(unsigned spins) noexcept {
+        if (spins < 64) {
+#if defined(__SSE2__)
+            _mm_pause();
+#endif
+        } else if (spins < 128) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds{50});
+        }
+    }
+
+public:
+    /**
+     * @brief Construct a pipeline, starts lexing.
+     *
+     * @tparam Last a predicate on the kind of a token.
+     * @param lexer the lexer with its input set, used only by the pipeline until it is destroyed.
+     * @param last tells which token ends the input (such as eof or no_match), it is passed on too.
+     */
+    template<typename Last>
+    token_pipeline(LexerT& lexer, Last last)
+      : m_producer{[this, &lexer, last] { produce(lexer, last); }} {}
+
+    token_pipeline(const token_pipeline&) = delete;
+    token_pipeline& operator=(const token_pipeline&) = delete;
+    /**
+     * @brief Destructor, stops the lexing thread.
+     *
+     */
+    ~token_pipeline() noexcept {
+        m_stopped.store(true, std::memory_order_relaxed);
+        m_producer.join();
+    }
+    /**
+     * @brief takes the tokens lexed so far, waits if there are none yet.
+     *
+     * @param tokens the array the tokens are moved to.
+     * @param count the size of the array.
+     * @return size_t the number of tokens taken, 0 once the last token was taken.
+     * @throws what lexing threw, once the tokens before were taken.
+     */
+    size_t next(token_t* tokens, size_t count) {
+        for (unsigned spins = 0;; ++spins) {
+            // checked before the ring, the tokens published before finishing are seen then.
+            auto finished = m_finished.load(std::memory_order_acquire);
+            if (auto taken = m_ring.try_pop(tokens, count)) return taken;
+
+            if (finished) {
+                if (m_error) std::rethrow_exception(std::exchange(m_error, nullptr));
+                return 0;
+            }
+            back_off(spins);
+        }
+    }
+    /**
+     * @brief takes the next token, waits if there is none yet.
+     *
+     * @param token the token taken.
+     * @return true if taken, false once the last token was taken.
+     */
+    bool next(token_t& token) { return next(&token, 1) == 1; }
+
+private:
+    template<typename Last>
+    void produce(LexerT& lexer, Last last) noexcept {
+        try {
+            while (!m_stopped.load(std::memory_order_relaxed)) {
+                // lexing may wait, the tokens so far shouldn't.
+                m_ring.publish();
+                auto token = lexer.lex();
+                auto done = last(std::get<0>(token));
+                // back pressure, waits until the consumer takes some.
+                for (unsigned spins = 0; !m_ring.try_push(std::move(token)); ++spins) {
+                    if (m_stopped.load(std::memory_order_relaxed)) return;
+
+                    back_off(spins);
+                }
+                if (done) break;
+            }
+        } catch (...) {
+            m_error = std::current_exception();
+        }
+
+        m_ring.publish();
+        m_finished.store(true, std::memory_order_release);
+    }
+};
+} // namespace ctle
+
+#endif // CTLE_PIPELINE
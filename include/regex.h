@@ -1,5 +1,8 @@
 #ifndef CTLE_REGEX
 #define CTLE_REGEX
+#include "regex_traits.h"
+#include "scan.h"
+
 #include <ctre.hpp>
 
 namespace ctle {
@@ -19,12 +22,34 @@ constexpr inline auto match_start(const Iterator begin, const EndIterator end,
 template<typename RE>
 struct regular_expression : public ctre::regular_expression<RE>
 {
+    /** @brief the syntax tree of this expression. */
+    using ast_t = RE;
+
     constexpr CTRE_FORCE_INLINE regular_expression() noexcept : ctre::regular_expression<RE>(){};
     constexpr CTRE_FORCE_INLINE regular_expression(RE) noexcept : ctre::regular_expression<RE>(){};
 
+    /**
+     * @brief matches from the beginning of the input, runs of a class (such as [a-z_][a-z_0-9]*+
+     * or [0-9]+) in char arrays are matched by scanning, see ctle::class_scan.
+     */
     template<typename IteratorBegin, typename IteratorEnd>
     constexpr CTRE_FORCE_INLINE static auto match_relaxed(IteratorBegin begin,
                                                           IteratorEnd   end) noexcept {
+        if constexpr (class_run_of<RE>::value && is_char_pointer<IteratorBegin>
+                      && std::is_same_v<IteratorBegin, IteratorEnd>) {
+            if (!std::is_constant_evaluated()) {
+                using return_type = decltype(match_start(begin, end, RE()));
+
+                return_type retval{};
+                auto        run_end = scan_class_run<RE>(begin, end);
+                if (run_end == begin) return retval;
+
+                retval.set_start_mark(begin);
+                retval.set_end_mark(begin + (run_end - begin));
+                retval.matched();
+                return retval;
+            }
+        }
         return match_start(begin, end, RE());
     }
 };
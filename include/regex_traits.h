@@ -0,0 +1,437 @@
+#ifndef CTLE_REGEX_TRAITS
+#define CTLE_REGEX_TRAITS
+
+#include <ctre.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace ctle {
+/**
+ * @brief checks whether a CTRE atom matches exactly one character (a character, a range, a set,
+ * any, ...).
+ */
+template<typename Ty>
+constexpr bool is_char_class = requires { Ty::match_char(char{}); };
+
+/**
+ * @brief A set of bytes (values of unsigned char).
+ */
+struct byte_set
+{
+    uint64_t words[4]{};
+    /** @brief the set of bytes a CTRE character class matches. */
+    template<typename CharClass>
+    static constexpr byte_set of() noexcept {
+        byte_set retval{};
+        for (size_t byte = 0; byte < 256; ++byte)
+            if (CharClass::match_char(static_cast<char>(byte))) retval.insert(byte);
+        return retval;
+    }
+    /** @brief the set of all bytes. */
+    static constexpr byte_set all() noexcept { return byte_set{{~0ull, ~0ull, ~0ull, ~0ull}}; }
+
+    constexpr void insert(size_t byte) noexcept { words[byte / 64] |= uint64_t{1} << (byte % 64); }
+
+    constexpr bool contains(size_t byte) const noexcept {
+        return (words[byte / 64] >> (byte % 64)) & 1;
+    }
+
+    /** @brief whether a byte is in both sets. */
+    constexpr bool intersects(const byte_set& other) const noexcept {
+        for (size_t i = 0; i < 4; ++i)
+            if (words[i] & other.words[i]) return true;
+        return false;
+    }
+
+    /** @brief the number of bytes in the set. */
+    constexpr size_t count() const noexcept {
+        size_t retval = 0;
+        for (size_t byte = 0; byte < 256; ++byte) retval += contains(byte);
+        return retval;
+    }
+
+    constexpr byte_set& operator|=(const byte_set& other) noexcept {
+        for (size_t i = 0; i < 4; ++i) words[i] |= other.words[i];
+        return *this;
+    }
+
+    constexpr bool operator==(const byte_set& other) const noexcept {
+        for (size_t i = 0; i < 4; ++i)
+            if (words[i] != other.words[i]) return false;
+        return true;
+    }
+};
+/**
+ * @brief The bytes a match of an expression can start with and whether it can match nothing at
+ * all (then whatever follows it can start the match too).
+ */
+struct first_set
+{
+    byte_set bytes{};
+    bool     nullable{true};
+
+    /** @brief the first set of this expression followed by other. */
+    constexpr first_set then(const first_set& other) const noexcept {
+        if (!nullable) return *this;
+
+        auto retval = other;
+        retval.bytes |= bytes;
+        return retval;
+    }
+    /** @brief the first set of either this expression or other. */
+    constexpr first_set either(const first_set& other) const noexcept {
+        auto retval = *this;
+        retval.bytes |= other.bytes;
+        retval.nullable = nullable || other.nullable;
+        return retval;
+    }
+};
+/**
+ * @brief Computes the first set of a CTRE syntax tree. It's conservative, atoms it does not know
+ * (anchors, lookaheads, backreferences, ...) are assumed to accept any byte or nothing at all,
+ * so a rule is never ruled out unless it really can't start with the byte.
+ *
+ * @tparam Ty the CTRE atom.
+ */
+template<typename Ty>
+struct first_of
+{
+    static constexpr first_set value() noexcept {
+        if constexpr (is_char_class<Ty>)
+            return first_set{byte_set::of<Ty>(), false};
+        else
+            return first_set{byte_set::all(), true};
+    }
+};
+
+template<>
+struct first_of<ctre::empty>
+{
+    static constexpr first_set value() noexcept { return first_set{}; }
+};
+
+template<typename... Content>
+struct first_of<ctre::sequence<Content...>>
+{
+    static constexpr first_set value() noexcept {
+        first_set retval{};
+        ((retval = retval.then(first_of<Content>::value())), ...);
+        return retval;
+    }
+};
+
+template<auto... Str>
+struct first_of<ctre::string<Str...>>
+  : first_of<ctre::sequence<ctre::character<Str>...>>
+{};
+
+template<typename... Options>
+struct first_of<ctre::select<Options...>>
+{
+    static constexpr first_set value() noexcept {
+        first_set retval{{}, false};
+        ((retval = retval.either(first_of<Options>::value())), ...);
+        return retval;
+    }
+};
+
+template<typename... Content>
+struct first_of<ctre::optional<Content...>>
+{
+    static constexpr first_set value() noexcept {
+        return first_set{first_of<ctre::sequence<Content...>>::value().bytes, true};
+    }
+};
+
+template<typename... Content>
+struct first_of<ctre::lazy_optional<Content...>> : first_of<ctre::optional<Content...>>
+{};
+
+template<size_t A, size_t B, typename... Content>
+struct first_of<ctre::repeat<A, B, Content...>>
+{
+    static constexpr first_set value() noexcept {
+        auto retval = first_of<ctre::sequence<Content...>>::value();
+        retval.nullable = retval.nullable || A == 0;
+        return retval;
+    }
+};
+
+template<size_t A, size_t B, typename... Content>
+struct first_of<ctre::lazy_repeat<A, B, Content...>>
+  : first_of<ctre::repeat<A, B, Content...>>
+{};
+
+template<size_t A, size_t B, typename... Content>
+struct first_of<ctre::possessive_repeat<A, B, Content...>>
+  : first_of<ctre::repeat<A, B, Content...>>
+{};
+
+template<size_t Id, typename... Content>
+struct first_of<ctre::capture<Id, Content...>> : first_of<ctre::sequence<Content...>>
+{};
+/** @brief the maximal length of an expression which can match texts of any length. */
+constexpr size_t unbounded_length = std::numeric_limits<size_t>::max();
+/**
+ * @brief Computes the maximal length of a match of a CTRE syntax tree, unbounded_length if there's
+ * none or it can't be told (backreferences, ...).
+ *
+ * @tparam Ty the CTRE atom.
+ */
+template<typename Ty>
+struct max_length_of
+{
+    static constexpr size_t value() noexcept { return is_char_class<Ty> ? 1 : unbounded_length; }
+};
+
+template<>
+struct max_length_of<ctre::empty>
+{
+    static constexpr size_t value() noexcept { return 0; }
+};
+
+template<typename... Content>
+struct max_length_of<ctre::sequence<Content...>>
+{
+    static constexpr size_t value() noexcept {
+        size_t retval = 0;
+        const size_t lengths[]{max_length_of<Content>::value()..., 0};
+        for (auto length : lengths)
+            retval = (retval == unbounded_length || length == unbounded_length) ? unbounded_length
+                                                                                : retval + length;
+        return retval;
+    }
+};
+
+template<auto... Str>
+struct max_length_of<ctre::string<Str...>>
+{
+    static constexpr size_t value() noexcept { return sizeof...(Str); }
+};
+
+template<typename... Options>
+struct max_length_of<ctre::select<Options...>>
+{
+    static constexpr size_t value() noexcept {
+        const size_t lengths[]{max_length_of<Options>::value()..., 0};
+
+        size_t retval = 0;
+        for (auto length : lengths)
+            if (length > retval) retval = length;
+        return retval;
+    }
+};
+
+template<typename... Content>
+struct max_length_of<ctre::optional<Content...>> : max_length_of<ctre::sequence<Content...>>
+{};
+
+template<typename... Content>
+struct max_length_of<ctre::lazy_optional<Content...>> : max_length_of<ctre::sequence<Content...>>
+{};
+
+template<size_t A, size_t B, typename... Content>
+struct max_length_of<ctre::repeat<A, B, Content...>>
+{
+    static constexpr size_t value() noexcept {
+        auto content = max_length_of<ctre::sequence<Content...>>::value();
+        if (content == 0) return 0;
+        if (B == 0 || content == unbounded_length) return unbounded_length;
+        return content * B;
+    }
+};
+
+template<size_t A, size_t B, typename... Content>
+struct max_length_of<ctre::lazy_repeat<A, B, Content...>>
+  : max_length_of<ctre::repeat<A, B, Content...>>
+{};
+
+template<size_t A, size_t B, typename... Content>
+struct max_length_of<ctre::possessive_repeat<A, B, Content...>>
+  : max_length_of<ctre::repeat<A, B, Content...>>
+{};
+
+template<size_t Id, typename... Content>
+struct max_length_of<ctre::capture<Id, Content...>> : max_length_of<ctre::sequence<Content...>>
+{};
+/**
+ * @brief concatenates ctre::string-s, the result is void if any of them is not a string.
+ */
+template<typename... Strings>
+struct join_strings
+{
+    using type = void;
+};
+
+template<>
+struct join_strings<>
+{
+    using type = ctre::string<>;
+};
+
+template<auto... Str>
+struct join_strings<ctre::string<Str...>>
+{
+    using type = ctre::string<Str...>;
+};
+
+template<auto... A, auto... B, typename... Rest>
+struct join_strings<ctre::string<A...>, ctre::string<B...>, Rest...>
+  : join_strings<ctre::string<A..., B...>, Rest...>
+{};
+/**
+ * @brief The only text an expression matches as a ctre::string, or void if it matches more texts
+ * (or it can't be told).
+ *
+ * @tparam Ty the CTRE atom.
+ */
+template<typename Ty>
+struct literal_of
+{
+    using type = void;
+};
+
+template<auto... Str>
+struct literal_of<ctre::string<Str...>>
+{
+    using type = ctre::string<Str...>;
+};
+
+template<auto C>
+struct literal_of<ctre::character<C>>
+{
+    using type = ctre::string<C>;
+};
+
+template<typename... Content>
+struct literal_of<ctre::sequence<Content...>>
+  : join_strings<typename literal_of<Content>::type...>
+{};
+/**
+ * @brief The text of a literal as ASCII characters.
+ *
+ * @tparam Ty a ctre::string, or void.
+ */
+template<typename Ty>
+struct literal_text
+{
+    static constexpr bool valid = false;
+};
+
+template<auto... Str>
+struct literal_text<ctre::string<Str...>>
+{
+    static constexpr bool valid = sizeof...(Str) && (true && ... && (Str >= 0 && Str < 128));
+    static constexpr char value[]{static_cast<char>(Str)..., 0};
+    static constexpr size_t size = sizeof...(Str);
+};
+/**
+ * @brief Describes expressions matching a run of characters of which the first is from one class
+ * and all others from another (identifiers), such as [a-z_][a-z_0-9]* or [0-9]+. The repetition
+ * is greedy or possessive, so such expression always matches the whole run.
+ *
+ * @tparam Ty the CTRE atom.
+ */
+template<typename Ty>
+struct class_run_of
+{
+    static constexpr bool value = false;
+};
+
+template<typename Head, typename Tail>
+struct class_run_of<ctre::sequence<Head, ctre::repeat<0, 0, Tail>>>
+{
+    static constexpr bool value = is_char_class<Head> && is_char_class<Tail>;
+    /** @brief the class of the rest of the run. */
+    using tail_t = Tail;
+    /** @brief the bytes the run can start with. */
+    static constexpr byte_set head() noexcept {
+        if constexpr (value)
+            return byte_set::of<Head>();
+        else
+            return byte_set{};
+    }
+    /** @brief the bytes the rest of the run consists of. */
+    static constexpr byte_set tail() noexcept {
+        if constexpr (value)
+            return byte_set::of<Tail>();
+        else
+            return byte_set{};
+    }
+};
+
+template<typename Head, typename Tail>
+struct class_run_of<ctre::sequence<Head, ctre::possessive_repeat<0, 0, Tail>>>
+  : class_run_of<ctre::sequence<Head, ctre::repeat<0, 0, Tail>>>
+{};
+
+template<typename Class>
+struct class_run_of<ctre::repeat<1, 0, Class>>
+  : class_run_of<ctre::sequence<Class, ctre::repeat<0, 0, Class>>>
+{};
+
+template<typename Class>
+struct class_run_of<ctre::possessive_repeat<1, 0, Class>>
+  : class_run_of<ctre::sequence<Class, ctre::repeat<0, 0, Class>>>
+{};
+/**
+ * @brief The same syntax tree with captures replaced by plain sequences, matching it is cheaper as
+ * CTRE doesn't have to record the captures.
+ *
+ * @tparam Ty the CTRE atom.
+ */
+template<typename Ty>
+struct strip_captures
+{
+    using type = Ty;
+};
+
+template<size_t Id, typename... Content>
+struct strip_captures<ctre::capture<Id, Content...>>
+{
+    using type = ctre::sequence<typename strip_captures<Content>::type...>;
+};
+
+template<template<typename...> typename Node, typename... Content>
+struct strip_captures<Node<Content...>>
+{
+    using type = Node<typename strip_captures<Content>::type...>;
+};
+
+template<template<size_t, size_t, typename...> typename Repeat, size_t A, size_t B,
+         typename... Content>
+struct strip_captures<Repeat<A, B, Content...>>
+{
+    using type = Repeat<A, B, typename strip_captures<Content>::type...>;
+};
+/**
+ * @brief checks whether an expression refers to a capture, then captures can't be stripped.
+ */
+template<typename Ty>
+constexpr bool uses_back_reference = false;
+
+template<size_t Id>
+constexpr bool uses_back_reference<ctre::back_reference<Id>> = true;
+
+template<size_t Id, typename... Content>
+constexpr bool uses_back_reference<ctre::capture<Id, Content...>>
+  = (false || ... || uses_back_reference<Content>);
+
+template<template<typename...> typename Node, typename... Content>
+constexpr bool uses_back_reference<Node<Content...>>
+  = (false || ... || uses_back_reference<Content>);
+
+template<template<size_t, size_t, typename...> typename Repeat, size_t A, size_t B,
+         typename... Content>
+constexpr bool uses_back_reference<Repeat<A, B, Content...>>
+  = (false || ... || uses_back_reference<Content>);
+/**
+ * @brief the syntax tree used to recognize a match (find its length) without captures.
+ */
+template<typename Ty>
+using recognizer_of
+  = std::conditional_t<uses_back_reference<Ty>, Ty, typename strip_captures<Ty>::type>;
+} // namespace ctle
+#endif // CTLE_REGEX_TRAITS
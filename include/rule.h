@@ -4,6 +4,8 @@
 #include "utils.h"
 #include "callable.h"
 #include "regex.h"
+#include "regex_traits.h"
+#include "skip.h"
 #include "container.h"
 
 #include <ctll/fixed_string.hpp>
@@ -24,6 +26,10 @@ class rule
 public:
     static constexpr auto action = Action;
     using pattern_t = decltype(make_re<Pattern>());
+    /** @brief the pattern without captures, used to just find the length of a match. */
+    using recognizer_t = regular_expression<recognizer_of<typename pattern_t::ast_t>>;
+    /** @brief the pattern as a shape matched by scanning, see ctle::skip_shape_of. */
+    using skip_shape_t = skip_shape_of<typename pattern_t::ast_t>;
     /**
      * @brief checks whether rule is valid in said state.
      */
@@ -42,6 +48,18 @@ public:
     static constexpr CTRE_FORCE_INLINE auto match(Ibegin begin, Iend end) noexcept {
         return pattern_t::match_relaxed(begin, end);
     }
+    /**
+     * @brief tries to match text by rule, without captures.
+     *
+     * @param begin begin iterator.
+     * @param end end iterator.
+     *
+     * @return a match_result containing just the matched text.
+     */
+    template<typename Ibegin, typename Iend>
+    static constexpr CTRE_FORCE_INLINE auto recognize(Ibegin begin, Iend end) noexcept {
+        return recognizer_t::match_relaxed(begin, end);
+    }
 };
 
 /**
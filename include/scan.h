@@ -0,0 +1,93 @@
+#ifndef CTLE_SCAN
+#define CTLE_SCAN
+
+#include "regex_traits.h"
+#include "simd.h"
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+namespace ctle {
+/** @brief checks whether an iterator is a pointer to char, which can be scanned. */
+template<typename Iterator>
+constexpr bool is_char_pointer
+  = std::is_pointer_v<Iterator>
+    && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Iterator>>, char>;
+/** @brief the most bytes a class may have (or lack) to be scanned for by comparing with each. */
+constexpr size_t max_compared_bytes = 3;
+/**
+ * @brief Scans for the end of a run of characters of a class. Classes of a few bytes, or lacking
+ * a few (such as [^\r\n]), are scanned by comparing with those bytes, others by looking up the
+ * nibbles of the bytes in tables (see ctle::simd::nibble_table), classes which contain only some
+ * bytes from 0x80 by looking up the bytes one by one.
+ *
+ * @tparam Class a CTRE character class.
+ */
+template<typename Class>
+class class_scan
+{
+    static constexpr byte_set m_set = byte_set::of<Class>();
+    static constexpr size_t   m_count = m_set.count();
+    static constexpr bool     m_compare_members = m_count <= max_compared_bytes;
+    static constexpr bool     m_compare = m_compare_members || 256 - m_count <= max_compared_bytes;
+
+    static constexpr bool high_half(bool contained) noexcept {
+        for (size_t byte = 0x80; byte < 256; ++byte)
+            if (m_set.contains(byte) != contained) return false;
+        return true;
+    }
+
+    static constexpr bool m_nibbles = high_half(true) || high_half(false);
+
+    template<size_t Size>
+    static constexpr auto make_bytes() noexcept {
+        std::array<uint8_t, Size> retval{};
+        for (size_t byte = 0, i = 0; byte < 256; ++byte)
+            if (m_set.contains(byte) == m_compare_members) retval[i++] = static_cast<uint8_t>(byte);
+        return retval;
+    }
+
+    static constexpr simd::nibble_table make_nibble_table() noexcept {
+        simd::nibble_table retval{{}, {}, high_half(true)};
+        for (size_t byte = 0; byte < 0x80; ++byte)
+            if (m_set.contains(byte)) retval.low[byte & 0x0f] |= uint8_t{1} << (byte >> 4);
+
+        for (size_t nibble = 0; nibble < 8; ++nibble) retval.high[nibble] = uint8_t{1} << nibble;
+        return retval;
+    }
+
+    static constexpr auto m_bytes = make_bytes<m_compare_members ? m_count : 256 - m_count>();
+    static constexpr auto m_table = make_nibble_table();
+
+public:
+    /** @brief finds the first byte not in the class. */
+    static CTRE_FORCE_INLINE const char* skip(const char* begin, const char* end) noexcept {
+        if constexpr (m_compare) {
+            return simd::find_first<!m_compare_members>(begin, end, m_bytes);
+        } else if constexpr (m_nibbles) {
+            return simd::find_first_outside(begin, end, m_table);
+        } else {
+            while (begin != end && m_set.contains(static_cast<uint8_t>(*begin))) ++begin;
+            return begin;
+        }
+    }
+};
+/**
+ * @brief matches an expression described by ctle::class_run_of, by scanning.
+ *
+ * @tparam Ty the CTRE atom, its class_run_of must be valid.
+ * @param begin the beginning of the input.
+ * @param end the end of the input.
+ * @return const char* the end of the match or begin if there is none.
+ */
+template<typename Ty>
+CTRE_FORCE_INLINE const char* scan_class_run(const char* begin, const char* end) noexcept {
+    using run_t = class_run_of<Ty>;
+    constexpr auto head = run_t::head();
+
+    if (begin == end || !head.contains(static_cast<uint8_t>(*begin))) return begin;
+    return class_scan<typename run_t::tail_t>::skip(begin + 1, end);
+}
+} // namespace ctle
+#endif // CTLE_SCAN
@@ -0,0 +1,155 @@
+#ifndef CTLE_SIMD
+#define CTLE_SIMD
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace ctle::simd {
+/**
+ * @brief checks whether a byte is one of bytes.
+ */
+template<size_t N>
+constexpr bool is_one_of(char byte, const std::array<uint8_t, N>& bytes) noexcept {
+    for (auto candidate : bytes)
+        if (static_cast<uint8_t>(byte) == candidate) return true;
+    return false;
+}
+/**
+ * @brief finds the first byte which is (or with Member false isn't) one of bytes. Compares 32
+ * bytes at a time with AVX2, 16 with SSE2 and the rest (or all without those) one by one.
+ *
+ * @tparam Member whether to look for a byte which is one of bytes or which is none of them.
+ * @param begin the beginning of the scanned bytes.
+ * @param end the end of the scanned bytes.
+ * @param bytes the bytes compared against, each costs one compare per block.
+ * @return const char* the first such byte or end if there is none.
+ */
+template<bool Member, size_t N>
+inline const char* find_first(const char* begin, const char* end,
+                              const std::array<uint8_t, N>& bytes) noexcept {
+#if defined(__AVX2__)
+    for (; end - begin >= 32; begin += 32) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        auto found = _mm256_setzero_si256();
+        for (auto byte : bytes)
+            found = _mm256_or_si256(
+              found, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(static_cast<char>(byte))));
+
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(found));
+        if constexpr (!Member) mask = ~mask;
+        if (mask) return begin + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    for (; end - begin >= 16; begin += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        auto found = _mm_setzero_si128();
+        for (auto byte : bytes)
+            found = _mm_or_si128(found,
+                                 _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(byte))));
+
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(found));
+        if constexpr (!Member) mask = ~mask & 0xffff;
+        if (mask) return begin + __builtin_ctz(mask);
+    }
+#endif
+    for (; begin != end; ++begin)
+        if (is_one_of(*begin, bytes) == Member) return begin;
+    return end;
+}
+/**
+ * @brief A class of bytes as two tables indexed by the low and the high nibble of a byte, a byte
+ * below 0x80 is in the class if its entries share a bit (a bit of the low table per high nibble).
+ * Bytes from 0x80 are either all in the class or none of them is.
+ */
+struct nibble_table
+{
+    alignas(16) uint8_t low[16];
+    alignas(16) uint8_t high[16];
+    bool high_half;
+};
+/**
+ * @brief finds the first byte which isn't in a class. Looks up the nibbles of 32 bytes at a time
+ * with AVX2, 16 with SSSE3 and the rest (or all without those) one by one.
+ *
+ * @param begin the beginning of the scanned bytes.
+ * @param end the end of the scanned bytes.
+ * @param table the class.
+ * @return const char* the first byte not in the class or end if there is none.
+ */
+inline const char* find_first_outside(const char* begin, const char* end,
+                                      const nibble_table& table) noexcept {
+#if defined(__AVX2__)
+    {
+        auto low = _mm256_broadcastsi128_si256(
+          _mm_load_si128(reinterpret_cast<const __m128i*>(table.low)));
+        auto high = _mm256_broadcastsi128_si256(
+          _mm_load_si128(reinterpret_cast<const __m128i*>(table.high)));
+        auto nibble = _mm256_set1_epi8(0x0f);
+        for (; end - begin >= 32; begin += 32) {
+            auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+            auto found = _mm256_and_si256(
+              _mm256_shuffle_epi8(low, _mm256_and_si256(block, nibble)),
+              _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble)));
+
+            auto mask = static_cast<uint32_t>(
+              _mm256_movemask_epi8(_mm256_cmpeq_epi8(found, _mm256_setzero_si256())));
+            if (table.high_half) mask &= ~static_cast<uint32_t>(_mm256_movemask_epi8(block));
+            if (mask) return begin + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSSE3__)
+    {
+        auto low = _mm_load_si128(reinterpret_cast<const __m128i*>(table.low));
+        auto high = _mm_load_si128(reinterpret_cast<const __m128i*>(table.high));
+        auto nibble = _mm_set1_epi8(0x0f);
+        for (; end - begin >= 16; begin += 16) {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            auto found = _mm_and_si128(
+              _mm_shuffle_epi8(low, _mm_and_si128(block, nibble)),
+              _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi16(block, 4), nibble)));
+
+            auto mask = static_cast<uint32_t>(
+              _mm_movemask_epi8(_mm_cmpeq_epi8(found, _mm_setzero_si128())));
+            if (table.high_half) mask &= ~static_cast<uint32_t>(_mm_movemask_epi8(block));
+            if (mask) return begin + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; begin != end; ++begin) {
+        auto byte = static_cast<uint8_t>(*begin);
+        if (byte >= 0x80 ? !table.high_half : !(table.low[byte & 0x0f] & table.high[byte >> 4]))
+            return begin;
+    }
+    return end;
+}
+/**
+ * @brief finds the first occurrence of a text, its first byte is searched for by find_first.
+ *
+ * @param begin the beginning of the scanned bytes.
+ * @param end the end of the scanned bytes.
+ * @param text the text to find, not empty.
+ * @return const char* the beginning of the text or end if it doesn't occur.
+ */
+inline const char* find_text(const char* begin, const char* end, std::string_view text) noexcept {
+    const std::array<uint8_t, 1> first{static_cast<uint8_t>(text[0])};
+    while (static_cast<size_t>(end - begin) >= text.size()) {
+        // the text can't begin any closer to the end.
+        auto last = end - text.size() + 1;
+        begin = find_first<true>(begin, last, first);
+        if (begin == last) break;
+        if (std::string_view{begin, text.size()} == text) return begin;
+
+        ++begin;
+    }
+    return end;
+}
+} // namespace ctle::simd
+#endif // CTLE_SIMD
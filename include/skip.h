@@ -0,0 +1,123 @@
+#ifndef CTLE_SKIP
+#define CTLE_SKIP
+
+#include "regex.h"
+#include "regex_traits.h"
+#include "scan.h"
+#include "simd.h"
+
+#include <array>
+#include <cstring>
+#include <string_view>
+
+namespace ctle {
+/** @brief checks whether an atom is a character class matching all bytes. */
+template<typename Ty>
+constexpr bool is_any_byte() noexcept {
+    if constexpr (is_char_class<Ty>)
+        return byte_set::of<Ty>() == byte_set::all();
+    else
+        return false;
+}
+/**
+ * @brief Describes expressions which mostly skip bytes (whitespace and comments) and can be
+ * matched by scanning many bytes at a time (see ctle::simd) instead of by CTRE. Those are
+ *  - a run of a class with optional alternatives, such as [ \t]+ or (?:[ \t\n]|\\\r?\n)+,
+ *  - a literal followed by a run of a class, such as //[^\r\n]*+,
+ *  - a literal followed by anything up to another literal, such as /\*.*?\*\/.
+ * Each provides match, which returns the end of the match or begin if there is none.
+ *
+ * @tparam Ty the CTRE atom.
+ */
+template<typename Ty>
+struct skip_shape_of
+{
+    static constexpr bool value = false;
+};
+
+template<size_t A, typename Class>
+struct skip_shape_of<ctre::repeat<A, 0, Class>>
+{
+    static constexpr bool value = A <= 1 && is_char_class<Class>;
+
+    static CTRE_FORCE_INLINE const char* match(const char* begin, const char* end) noexcept {
+        return class_scan<Class>::skip(begin, end);
+    }
+};
+
+template<size_t A, typename Class, typename... Alternatives>
+struct skip_shape_of<ctre::repeat<A, 0, ctre::select<Class, Alternatives...>>>
+{
+    static constexpr bool value = A <= 1 && is_char_class<Class>;
+
+    static CTRE_FORCE_INLINE const char* match(const char* begin, const char* end) noexcept {
+        using alternatives_t = regular_expression<ctre::select<Alternatives...>>;
+        constexpr auto alternatives_first = first_of<ctre::select<Alternatives...>>::value();
+
+        auto it = begin;
+        while (true) {
+            it = class_scan<Class>::skip(it, end);
+            // the class didn't match, so the alternatives are tried in their order.
+            if (it == end
+                || !(alternatives_first.nullable
+                     || alternatives_first.bytes.contains(static_cast<uint8_t>(*it))))
+                break;
+
+            auto result = alternatives_t::match_relaxed(it, end);
+            if (!result) break;
+
+            auto length = std::string_view(result.template get<0>()).size();
+            if (!length) break;
+
+            it += length;
+        }
+        return it;
+    }
+};
+
+template<size_t A, size_t B, typename... Content>
+struct skip_shape_of<ctre::possessive_repeat<A, B, Content...>>
+  : skip_shape_of<ctre::repeat<A, B, Content...>>
+{};
+
+template<typename Open, typename Class>
+struct skip_shape_of<ctre::sequence<Open, ctre::repeat<0, 0, Class>>>
+{
+    using open_t = literal_text<typename literal_of<Open>::type>;
+
+    static constexpr bool value = open_t::valid && is_char_class<Class>;
+
+    static CTRE_FORCE_INLINE const char* match(const char* begin, const char* end) noexcept {
+        if (static_cast<size_t>(end - begin) < open_t::size
+            || std::memcmp(begin, open_t::value, open_t::size))
+            return begin;
+
+        return class_scan<Class>::skip(begin + open_t::size, end);
+    }
+};
+
+template<typename Open, typename Class>
+struct skip_shape_of<ctre::sequence<Open, ctre::possessive_repeat<0, 0, Class>>>
+  : skip_shape_of<ctre::sequence<Open, ctre::repeat<0, 0, Class>>>
+{};
+
+template<typename Open, typename Class, typename Close>
+struct skip_shape_of<ctre::sequence<Open, ctre::lazy_repeat<0, 0, Class>, Close>>
+{
+    using open_t = literal_text<typename literal_of<Open>::type>;
+    using close_t = literal_text<typename literal_of<Close>::type>;
+
+    static constexpr bool value = open_t::valid && close_t::valid && is_any_byte<Class>();
+
+    static CTRE_FORCE_INLINE const char* match(const char* begin, const char* end) noexcept {
+        if (static_cast<size_t>(end - begin) < open_t::size
+            || std::memcmp(begin, open_t::value, open_t::size))
+            return begin;
+
+        constexpr std::string_view close{close_t::value, close_t::size};
+        auto retval = simd::find_text(begin + open_t::size, end, close);
+        return retval != end ? retval + close_t::size : begin;
+    }
+};
+} // namespace ctle
+#endif // CTLE_SKIP
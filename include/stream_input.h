@@ -0,0 +1,159 @@
+#ifndef CTLE_STREAM_INPUT
+#define CTLE_STREAM_INPUT
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace ctle {
+/**
+ * @brief The result of refilling a streamed input.
+ */
+enum class stream_status
+{
+    /** @brief something was read. */
+    read,
+    /** @brief nothing is there to read yet (a non-blocking descriptor, or not waited for). */
+    pending,
+    /** @brief the end of the stream, a growing file may still be read on later. */
+    end,
+    /** @brief reading failed. */
+    failed
+};
+/**
+ * @brief An input read from a file descriptor (a pipe, stdin, a growing file, ...) into a buffer
+ * of fixed capacity, so that its size doesn't have to be known up front and memory stays bounded.
+ * The lexer refills it as it goes (see lexer::set_input), keeping the unfinished token and moving
+ * it to the front of the buffer. Tokens longer than half the capacity may be split. Reaching the end
+ * of the stream (or of what a non-blocking descriptor has for now) is not final, the next refill
+ * reads again, so lexing goes on once more is written.
+ *
+ * @tparam CharT the character type.
+ */
+template<typename CharT>
+class basic_stream_input
+{
+    int                      m_fd{-1};
+    bool                     m_owns_fd{false};
+    stream_status            m_status{stream_status::read};
+    size_t                   m_capacity{0};
+    std::unique_ptr<CharT[]> m_buffer;
+    /** @brief the bytes read into the buffer, may end in a part of a character. */
+    size_t m_bytes{0};
+    /** @brief the number of characters dropped from the front of the buffer. */
+    size_t m_offset{0};
+
+public:
+    using char_t = CharT;
+    using iterator_t = const char_t*;
+    /** @brief the capacity used if none is specified, in characters. */
+    static constexpr size_t default_capacity = size_t{1} << 16;
+    /**
+     * @brief Construct an input reading from a file descriptor, which is not closed by it.
+     *
+     * @param fd the file descriptor, e.g. STDIN_FILENO.
+     * @param capacity the size of the buffer in characters.
+     */
+    explicit basic_stream_input(int fd, size_t capacity = default_capacity);
+    /**
+     * @brief Construct an input reading a file, opens the file, throws if cannot open.
+     *
+     * @param path the path to the file.
+     * @param capacity the size of the buffer in characters.
+     */
+    explicit basic_stream_input(const std::filesystem::path& path,
+                                size_t                       capacity = default_capacity);
+
+    basic_stream_input(const basic_stream_input&) = delete;
+    basic_stream_input& operator=(const basic_stream_input&) = delete;
+    /**
+     * @brief Destructor.
+     *
+     */
+    ~basic_stream_input() noexcept;
+    /**
+     * @brief drops the characters before keep, moves the rest to the front of the buffer and reads
+     * once, whatever is there (up to the free space), so that what a pipe has is lexed right away.
+     *
+     * @param keep the first character to keep, within [begin(), end()].
+     * @param wait whether to wait for something to read, otherwise only reads what is there.
+     * @return true if something was read, otherwise status() tells why not.
+     */
+    bool refill(const CharT* keep, bool wait = true) noexcept;
+
+    // accessors
+    const CharT* begin() const noexcept { return m_buffer.get(); }
+
+    const CharT* end() const noexcept { return m_buffer.get() + size(); }
+
+    size_t size() const noexcept { return m_bytes / sizeof(CharT); }
+
+    size_t capacity() const noexcept { return m_capacity; }
+    /** @brief the offset of begin() from the beginning of the stream, in characters. */
+    size_t offset() const noexcept { return m_offset; }
+    /** @brief the result of the last refill. */
+    stream_status status() const noexcept { return m_status; }
+    /** @brief whether the last refill found nothing to read yet, try again later. */
+    bool pending() const noexcept { return m_status == stream_status::pending; }
+    /** @brief whether the last refill reached the end of the stream (or reading failed). */
+    bool exhausted() const noexcept {
+        return m_status == stream_status::end || m_status == stream_status::failed;
+    }
+};
+
+// implementation
+
+template<typename CharT>
+basic_stream_input<CharT>::basic_stream_input(int fd, size_t capacity)
+  : m_fd{fd}, m_capacity{capacity}, m_buffer{std::make_unique<CharT[]>(capacity)} {}
+
+template<typename CharT>
+basic_stream_input<CharT>::basic_stream_input(const std::filesystem::path& path, size_t capacity)
+  : m_fd{open(path.c_str(), O_RDONLY)}, m_owns_fd{true}, m_capacity{capacity},
+    m_buffer{std::make_unique<CharT[]>(capacity)} {
+    if (m_fd < 0) throw std::runtime_error("File could not be opened.");
+}
+
+template<typename CharT>
+basic_stream_input<CharT>::~basic_stream_input() noexcept {
+    if (m_owns_fd) close(m_fd);
+}
+
+template<typename CharT>
+bool basic_stream_input<CharT>::refill(const CharT* keep, bool wait) noexcept {
+    auto buffer = reinterpret_cast<char*>(m_buffer.get());
+    auto dropped = static_cast<size_t>(keep - begin());
+    // the part of a character at the end is moved as well.
+    m_bytes -= dropped * sizeof(CharT);
+    std::memmove(buffer, buffer + dropped * sizeof(CharT), m_bytes);
+    m_offset += dropped;
+
+    m_status = stream_status::pending;
+    auto room = m_capacity * sizeof(CharT) - m_bytes;
+    if (!room) return false;
+    // a regular file is always ready, a pipe only once something was written.
+    pollfd ready{m_fd, POLLIN, 0};
+    if (!wait && poll(&ready, 1, 0) == 0) return false;
+
+    auto count = read(m_fd, buffer + m_bytes, room);
+    while (count < 0 && errno == EINTR) count = read(m_fd, buffer + m_bytes, room);
+
+    if (count > 0) {
+        m_bytes += static_cast<size_t>(count);
+        m_status = stream_status::read;
+    } else if (count == 0) {
+        m_status = stream_status::end;
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        m_status = stream_status::failed;
+    }
+    return count > 0;
+}
+} // namespace ctle
+
+#endif // CTLE_STREAM_INPUT
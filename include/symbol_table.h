@@ -0,0 +1,198 @@
+#ifndef CTLE_SYMBOL_TABLE
+#define CTLE_SYMBOL_TABLE
+
+#include "utils.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace ctle {
+/** @brief the identifier of an interned lexeme, see ctle::basic_symbol_table. */
+using symbol_id = uint32_t;
+/**
+ * @brief Interns lexemes (such as identifiers), each distinct text gets a dense symbol_id and is
+ * stored once, in blocks which don't move, so the text of a symbol stays valid as long as the table
+ * does, also once the input it was lexed from is gone. The slots (open addressing, linear probing)
+ * are 8 bytes, the upper half of the hash and the id, the whole hash of each symbol is kept so that
+ * neither growing the table nor its users hash the text again. Not synchronized, a table is used by
+ * one thread.
+ *
+ * @tparam CharT the type of characters.
+ */
+template<typename CharT>
+class basic_symbol_table
+{
+public:
+    using char_t = CharT;
+    using string_view_t = std::basic_string_view<CharT>;
+    /** @brief no symbol, returned by find if the text was never interned. */
+    static constexpr symbol_id none = std::numeric_limits<symbol_id>::max();
+    /**
+     * @brief Construct an empty table.
+     *
+     * @param capacity the number of symbols it holds before growing.
+     * @param block_size the number of characters of a block of texts.
+     */
+    explicit basic_symbol_table(size_t capacity = 1024, size_t block_size = size_t{1} << 16);
+    /**
+     * @brief interns a text, hashing it with hash_lexeme.
+     *
+     * @return symbol_id the symbol of the text, a new one if the text is new.
+     */
+    symbol_id intern(string_view_t text) { return intern(text, hash_lexeme(text)); }
+    /**
+     * @brief interns a text whose hash is already known.
+     *
+     * @param text the text.
+     * @param hash hash_lexeme of the text.
+     * @return symbol_id the symbol of the text, a new one if the text is new.
+     * @throws std::length_error if the text is new and all ids but none are taken.
+     */
+    symbol_id intern(string_view_t text, uint64_t hash);
+    /**
+     * @brief finds the symbol of a text, without interning it.
+     *
+     * @return symbol_id the symbol or none.
+     */
+    symbol_id find(string_view_t text) const noexcept { return find(text, hash_lexeme(text)); }
+
+    symbol_id find(string_view_t text, uint64_t hash) const noexcept;
+
+    // accessors
+    /** @brief the text of a symbol, owned by the table. */
+    string_view_t text(symbol_id id) const noexcept {
+        return string_view_t{m_symbols[id].text, m_symbols[id].length};
+    }
+    /** @brief hash_lexeme of the text of a symbol. */
+    uint64_t hash(symbol_id id) const noexcept { return m_symbols[id].hash; }
+    /** @brief the number of symbols. */
+    size_t size() const noexcept { return m_symbols.size(); }
+    /** @brief the number of bytes the texts take. */
+    size_t text_bytes() const noexcept { return m_text_bytes; }
+
+private:
+    struct slot_t
+    {
+        uint32_t  tag;
+        symbol_id id{none};
+    };
+
+    struct symbol_t
+    {
+        const CharT* text;
+        size_t       length;
+        uint64_t     hash;
+    };
+
+    std::vector<slot_t>                   m_slots;
+    std::vector<symbol_t>                 m_symbols;
+    std::vector<std::unique_ptr<CharT[]>> m_blocks;
+    size_t                                m_block_size;
+    // the characters left in the last block.
+    size_t m_block_left{0};
+    size_t m_text_bytes{0};
+
+    static uint32_t tag_of(uint64_t hash) noexcept { return static_cast<uint32_t>(hash >> 32); }
+
+    size_t first_slot(uint64_t hash) const noexcept {
+        return (hash * 0x9e3779b97f4a7c15ull) >> (64 - __builtin_ctzll(m_slots.size()));
+    }
+    /** @brief doubles the slots, placing the symbols by the hashes kept. */
+    void grow();
+    /** @brief copies a text to the blocks. */
+    const CharT* store(string_view_t text);
+};
+
+using symbol_table = basic_symbol_table<char>;
+
+// implementation
+
+template<typename CharT>
+basic_symbol_table<CharT>::basic_symbol_table(size_t capacity, size_t block_size)
+  : m_block_size{std::max<size_t>(block_size, 1)} {
+    // at most half of the slots are used.
+    size_t slots = 2;
+    while (slots < 2 * capacity) slots *= 2;
+    m_slots.resize(slots);
+    m_symbols.reserve(capacity);
+}
+
+template<typename CharT>
+symbol_id basic_symbol_table<CharT>::intern(string_view_t text, uint64_t hash) {
+    auto mask = m_slots.size() - 1;
+    auto index = first_slot(hash);
+    for (; m_slots[index].id != none; index = (index + 1) & mask) {
+        const auto& slot = m_slots[index];
+        if (slot.tag == tag_of(hash) && m_symbols[slot.id].hash == hash
+            && this->text(slot.id) == text)
+            return slot.id;
+    }
+
+    if (m_symbols.size() >= none) [[unlikely]]
+        throw std::length_error("No symbol ids are left.");
+
+    auto id = static_cast<symbol_id>(m_symbols.size());
+    m_symbols.push_back(symbol_t{store(text), text.size(), hash});
+    m_slots[index] = slot_t{tag_of(hash), id};
+
+    if (2 * m_symbols.size() > m_slots.size()) grow();
+    return id;
+}
+
+template<typename CharT>
+symbol_id basic_symbol_table<CharT>::find(string_view_t text, uint64_t hash) const noexcept {
+    auto mask = m_slots.size() - 1;
+    for (auto index = first_slot(hash); m_slots[index].id != none; index = (index + 1) & mask) {
+        const auto& slot = m_slots[index];
+        if (slot.tag == tag_of(hash) && m_symbols[slot.id].hash == hash
+            && this->text(slot.id) == text)
+            return slot.id;
+    }
+    return none;
+}
+
+template<typename CharT>
+void basic_symbol_table<CharT>::grow() {
+    std::vector<slot_t> slots(2 * m_slots.size());
+    std::swap(m_slots, slots);
+
+    auto mask = m_slots.size() - 1;
+    for (const auto& slot : slots) {
+        if (slot.id == none) continue;
+
+        auto index = first_slot(m_symbols[slot.id].hash);
+        while (m_slots[index].id != none) index = (index + 1) & mask;
+        m_slots[index] = slot;
+    }
+}
+
+template<typename CharT>
+const CharT* basic_symbol_table<CharT>::store(string_view_t text) {
+    m_text_bytes += text.size() * sizeof(CharT);
+    if (text.empty()) return nullptr;
+    // texts larger than a block get one of their own, the block being filled stays the last one.
+    if (text.size() > m_block_size) {
+        m_blocks.push_back(std::make_unique<CharT[]>(text.size()));
+        auto retval = m_blocks.back().get();
+        std::copy(text.begin(), text.end(), retval);
+        if (m_block_left) std::swap(m_blocks.back(), m_blocks[m_blocks.size() - 2]);
+        return retval;
+    }
+
+    if (text.size() > m_block_left) {
+        m_blocks.push_back(std::make_unique<CharT[]>(m_block_size));
+        m_block_left = m_block_size;
+    }
+
+    auto retval = m_blocks.back().get() + (m_block_size - m_block_left);
+    std::copy(text.begin(), text.end(), retval);
+    m_block_left -= text.size();
+    return retval;
+}
+} // namespace ctle
+#endif // CTLE_SYMBOL_TABLE
@@ -0,0 +1,70 @@
+#ifndef CTLE_TOKEN
+#define CTLE_TOKEN
+
+#include "utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace ctle {
+/**
+ * @brief Columns of tokens filled by lexer::lex_batch, the arrays are provided by the caller and
+ * each has an element per token.
+ *
+ * @tparam KindT the return type of rules.
+ */
+template<typename KindT>
+struct token_columns
+{
+    /** @brief the values returned by actions. */
+    KindT* kinds;
+    /** @brief offsets of the lexemes from the beginning of the input. */
+    size_t* offsets;
+    /** @brief lengths of the lexemes. */
+    size_t* lengths;
+    /** @brief the number of elements of each array. */
+    size_t capacity;
+};
+/**
+ * @brief A token with its lexeme as a 32 bit offset from the beginning of the input and a 32 bit
+ * length instead of a string_view, returned by lexer::lex_compact. Half the size of the lexeme in
+ * a token returned by lexer::lex, the lexeme can be obtained from the input when needed. Inputs
+ * have to be shorter than 4 GiB.
+ *
+ * @tparam KindT the return type of rules.
+ */
+template<typename KindT>
+struct compact_token
+{
+    KindT    kind;
+    uint32_t offset;
+    uint32_t length;
+    /**
+     * @brief gets the lexeme from the input the token was lexed from. Not for a streamed input,
+     * its offsets are from the beginning of the stream, which is no longer in the buffer.
+     *
+     * @param input a ctle::basic_file or anything with begin() over contiguous characters.
+     * @return std::basic_string_view the lexeme.
+     */
+    template<typename InputT>
+    requires(!requires(InputT& stream) { stream.refill(stream.begin(), true); })
+    auto lexeme(const InputT& input) const noexcept {
+        using char_t = std::remove_cvref_t<decltype(*input.begin())>;
+        return std::basic_string_view<char_t>{&*input.begin() + offset, length};
+    }
+    /**
+     * @brief gets the lexeme from the input range the token was lexed from.
+     *
+     * @param input the range set as input of the lexer.
+     * @return std::basic_string_view the lexeme.
+     */
+    template<typename IteratorT>
+    auto lexeme(const input_range<IteratorT>& input) const noexcept {
+        using char_t = std::remove_cvref_t<decltype(*input.begin)>;
+        return std::basic_string_view<char_t>{&*input.begin + offset, length};
+    }
+};
+} // namespace ctle
+#endif // CTLE_TOKEN
@@ -7,6 +7,8 @@
 #include <ctll/fixed_string.hpp>
 #include <ctll/utilities.hpp>
 #include <array>
+#include <cstdint>
+#include <string_view>
 
 namespace ctle {
 /**
@@ -97,6 +99,20 @@ static constexpr auto concat() {
     return ctll::fixed_string(buffer);
 }
 
+/**
+ * @brief FNV-1a hash of a lexeme, usable at compile time.
+ *
+ * @param lexeme the text to hash.
+ * @return uint64_t the hash.
+ */
+template<typename CharT>
+constexpr uint64_t hash_lexeme(std::basic_string_view<CharT> lexeme) noexcept {
+    uint64_t retval = 14695981039346656037ull;
+    for (auto c : lexeme)
+        retval = (retval ^ static_cast<std::make_unsigned_t<CharT>>(c)) * 1099511628211ull;
+    return retval;
+}
+
 namespace capture {
     /**
      * @brief Used in a fold expression to count captures in a regex.
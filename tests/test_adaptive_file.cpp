@@ -0,0 +1,93 @@
+#include "adaptive_file.h"
+
+#include <catch2.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+using file_t = ctle::basic_adaptive_file<char, 1024>;
+
+/** @brief a directory with a file up to the threshold, one above it and an empty one. */
+struct directory
+{
+    std::filesystem::path path;
+    std::string           small = std::string(1024, 'a');
+    std::string           large = std::string(5000, 'b');
+
+    directory() {
+        char name[] = "/tmp/ctle_adaptive_XXXXXX";
+        REQUIRE(mkdtemp(name));
+        path = name;
+
+        std::ofstream{path / "small", std::ios::binary} << small;
+        std::ofstream{path / "other", std::ios::binary} << "cd";
+        std::ofstream{path / "large", std::ios::binary} << large;
+        std::ofstream{path / "empty", std::ios::binary};
+    }
+
+    ~directory() { std::filesystem::remove_all(path); }
+};
+
+std::string_view view(const file_t& file) { return std::string_view{file.begin(), file.size()}; }
+} // namespace
+
+TEST_CASE("Test reading or mapping a file.", "[ctle::basic_adaptive_file]") {
+    directory files;
+
+    SECTION("A file up to the threshold is read.") {
+        file_t file{files.path / "small"};
+        REQUIRE(!file.mapped());
+        REQUIRE(view(file) == files.small);
+    }
+
+    SECTION("A file above the threshold is mapped.") {
+        file_t file{files.path / "large"};
+        REQUIRE(file.mapped());
+        REQUIRE(view(file) == files.large);
+    }
+
+    SECTION("An empty file.") {
+        file_t file{files.path / "empty"};
+        REQUIRE(file.size() == 0);
+    }
+
+    SECTION("A file which can't be opened or read.") {
+        REQUIRE_THROWS_AS(file_t{files.path / "missing"}, std::runtime_error);
+        // a directory opens, but reading it fails (mapping it fails too).
+        REQUIRE(!ctle::basic_adaptive_file<char>::create(files.path));
+        REQUIRE(!file_t::create(files.path));
+    }
+}
+
+TEST_CASE("Test reusing the buffers of read files.", "[ctle::basic_adaptive_file]") {
+    directory   files;
+    const char* buffer;
+    {
+        file_t file{files.path / "small"};
+        buffer = file.begin();
+    }
+
+    SECTION("A buffer is reused once the file is destroyed.") {
+        file_t file{files.path / "other"};
+        REQUIRE(file.begin() == buffer);
+        REQUIRE(view(file) == "cd");
+    }
+
+    SECTION("Initializing again returns the buffer to the pool first.") {
+        file_t file{files.path / "other"};
+        REQUIRE(file.initialize(files.path / "small"));
+        REQUIRE(file.begin() == buffer);
+        REQUIRE(view(file) == files.small);
+
+        REQUIRE(file.initialize(files.path / "large"));
+        REQUIRE(file.mapped());
+        REQUIRE(view(file) == files.large);
+
+        file_t next{files.path / "other"};
+        REQUIRE(next.begin() == buffer);
+    }
+}
@@ -0,0 +1,78 @@
+#include "batch_loader.h"
+
+#include <catch2.h>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+/** @brief a directory of files of uneven sizes, an empty one and a path which doesn't exist. */
+struct directory
+{
+    std::filesystem::path              path;
+    std::vector<std::filesystem::path> paths;
+    std::vector<std::string>           contents;
+
+    explicit directory(size_t count) {
+        char name[] = "/tmp/ctle_batch_XXXXXX";
+        REQUIRE(mkdtemp(name));
+        path = name;
+
+        for (size_t i = 0; i < count; ++i) {
+            // every 7th is empty, the sizes are up to about 200 kB.
+            auto size = (i % 7) ? (i * 7919) % 200000 : 0;
+            contents.emplace_back(size, static_cast<char>('a' + i % 26));
+            paths.push_back(path / std::to_string(i));
+            std::ofstream{paths.back(), std::ios::binary} << contents.back();
+        }
+        paths.push_back(path / "missing");
+    }
+
+    ~directory() { std::filesystem::remove_all(path); }
+};
+
+/** @brief loads all files, checks each is returned once with its content or error. */
+void require_loaded(const directory& files, unsigned depth) {
+    ctle::basic_batch_loader<char> loader{files.paths, depth};
+    if (!depth) REQUIRE(!loader.asynchronous());
+
+    std::vector<int> returned(files.paths.size());
+    while (auto file = loader.next()) {
+        REQUIRE(file->index() < files.paths.size());
+        ++returned[file->index()];
+
+        if (file->index() == files.contents.size()) {
+            REQUIRE(file->error() == ENOENT);
+            continue;
+        }
+        REQUIRE(file->error() == 0);
+        REQUIRE(std::string_view{file->begin(), file->size()} == files.contents[file->index()]);
+    }
+    REQUIRE(!loader.next());
+    for (auto count : returned) REQUIRE(count == 1);
+}
+} // namespace
+
+TEST_CASE("Test loading files.", "[ctle::basic_batch_loader]") {
+    directory files{40};
+
+    SECTION("More files than the depth of the ring.") { require_loaded(files, 4); }
+
+    SECTION("A ring deeper than the number of files.") { require_loaded(files, 64); }
+
+    SECTION("Blocking reads, as without io_uring.") { require_loaded(files, 0); }
+
+    SECTION("Files not asked for are closed by the destructor.") {
+        ctle::basic_batch_loader<char> loader{files.paths, 8};
+        REQUIRE(loader.next());
+    }
+
+    SECTION("No files.") {
+        ctle::basic_batch_loader<char> loader{{}, 4};
+        REQUIRE(!loader.next());
+    }
+}
@@ -0,0 +1,128 @@
+#include "checkpoint_index.h"
+#include "default_actions.h"
+#include "lexer.h"
+#include "rule.h"
+
+#include <catch2.h>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+enum class tokens { word = ctle::state_reserved, comment, eof, no_match };
+enum class states { comment = ctle::state_reserved };
+
+/** @brief switches to a state without returning a token. */
+template<auto State>
+struct switch_to
+{
+    constexpr void operator()(auto& lexer, auto&&...) const {
+        lexer.template set_state<State>();
+    }
+};
+
+using rules = ctll::list<
+  ctle::rule<"[a-z]+", ctle::default_actions::simple_return(tokens::word)>,
+  ctle::rule<"[ \\n]+">, ctle::rule<"/\\*", switch_to<states::comment>{}>,
+  ctle::rule<"\\*/", switch_to<ctle::state_initial>{}, std::array{states::comment}>,
+  ctle::rule<"[^*]++|\\*", ctle::default_actions::simple_return(tokens::comment),
+             std::array{states::comment}>>;
+
+using states_t = ctle::states<states, ctll::list<ctle::state<states::comment, true>>>;
+using lexer_t = ctle::lexer<tokens, rules, states_t>;
+
+bool is_last(tokens kind) { return kind == tokens::eof || kind == tokens::no_match; }
+
+using index_t = ctle::checkpoint_index<lexer_t, decltype(&is_last)>;
+
+/** @brief the bytes of a saved index, the header is followed by the positions. */
+constexpr size_t positions_at = 8 + 3 * sizeof(uint64_t);
+
+/** @brief overwrites a field of a position in a saved index. */
+template<typename Ty>
+void patch(std::string& saved, size_t position, size_t field, Ty value) {
+    saved.replace(positions_at + position * sizeof(ctle::position_checkpoint) + field,
+                  sizeof(value), reinterpret_cast<const char*>(&value), sizeof(value));
+}
+} // namespace
+
+TEST_CASE("Test indexing positions.", "[ctle::checkpoint_index]") {
+    std::string text;
+    for (int i = 0; i < 40; ++i) text += i % 3 ? "ab cd ef\n" : "/* gh\nij */ kl\n";
+    std::string_view input = text;
+
+    index_t built{is_last, 32};
+    built.build(input);
+    REQUIRE(built.checkpoints().size() > 4);
+
+    std::stringstream stream;
+    REQUIRE(built.save(stream));
+    auto saved = stream.str();
+
+    SECTION("The tokens of a part are those of lexing the whole input.") {
+        index_t            loaded{is_last};
+        std::istringstream in{saved};
+        REQUIRE(loaded.load(in));
+        REQUIRE(loaded.input_size() == input.size());
+
+        lexer_t lexer;
+        lexer.set_input(input);
+        std::vector<std::tuple<tokens, size_t, size_t>> all;
+        while (true) {
+            auto token = lexer.lex_compact();
+            all.emplace_back(token.kind, token.offset, token.length);
+            if (is_last(token.kind)) break;
+        }
+
+        for (auto [begin, end] : {std::pair<size_t, size_t>{0, 10}, {45, 46}, {100, 180},
+                                  {input.size() - 5, input.size() + 1}}) {
+            std::vector<std::tuple<tokens, std::string_view>> expected;
+            for (auto [kind, offset, length] : all)
+                if (offset < end && (offset + length > begin || offset >= begin))
+                    expected.emplace_back(kind, input.substr(offset, length));
+
+            auto part = loaded.tokens_in(input, begin, end);
+            REQUIRE(part.size() == expected.size());
+            for (size_t i = 0; i < part.size(); ++i) {
+                REQUIRE(std::get<0>(part[i]) == std::get<0>(expected[i]));
+                REQUIRE(std::get<1>(part[i]) == std::get<1>(expected[i]));
+            }
+        }
+    }
+
+    SECTION("Positions out of order, past the input or in unknown states are rejected.") {
+        auto offset = offsetof(ctle::position_checkpoint, offset);
+        auto state = offsetof(ctle::position_checkpoint, state);
+        for (auto corrupt : {0, 1, 2, 3}) {
+            auto bad = saved;
+            if (corrupt == 0) patch(bad, 2, offset, uint64_t{1});
+            if (corrupt == 1) patch(bad, 1, offset, uint64_t{input.size() + 1});
+            if (corrupt == 2) patch(bad, 1, state, int64_t{12345});
+            if (corrupt == 3) patch(bad, 0, offset, uint64_t{3});
+
+            index_t            loaded{is_last};
+            std::istringstream in{bad};
+            REQUIRE(!loaded.load(in));
+            REQUIRE(loaded.checkpoints().empty());
+        }
+    }
+
+    SECTION("Too many positions are rejected.") {
+        auto bad = saved;
+        auto count = uint64_t{1} << 40;
+        bad.replace(8 + 2 * sizeof(uint64_t), sizeof(count), reinterpret_cast<const char*>(&count),
+                    sizeof(count));
+
+        index_t            loaded{is_last};
+        std::istringstream in{bad};
+        REQUIRE(!loaded.load(in));
+    }
+
+    SECTION("Another input is rejected.") {
+        REQUIRE_THROWS_AS(built.tokens_in(input.substr(1), 0, 10), std::invalid_argument);
+    }
+}
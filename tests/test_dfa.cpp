@@ -0,0 +1,66 @@
+#include "dfa.h"
+#include "rule.h"
+
+#include <catch2.h>
+
+template<ctll::fixed_string... Patterns>
+using automaton_t = ctle::dfa::automaton<1024, typename ctle::rule<Patterns>::pattern_t::ast_t...>;
+
+template<typename Automaton>
+constexpr auto run(std::string_view input) {
+    return Automaton::match(input.begin(), input.end());
+}
+
+TEST_CASE("Test longest match of the automaton.", "[ctle::dfa::automaton]") {
+    using automaton = automaton_t<"if", "int", "[a-z_][a-z_0-9]*+", "[ \t\n]+", "[0-9]+(?:u|ll)?">;
+
+    SECTION("Keyword wins over identifier of the same length.") {
+        STATIC_REQUIRE(run<automaton>("if(").length == 2);
+        STATIC_REQUIRE(run<automaton>("if(").rule == 0);
+        STATIC_REQUIRE(run<automaton>("int x").rule == 1);
+    }
+
+    SECTION("Longer match wins.") {
+        STATIC_REQUIRE(run<automaton>("iffy ").length == 4);
+        STATIC_REQUIRE(run<automaton>("iffy ").rule == 2);
+        STATIC_REQUIRE(run<automaton>(" \t\nx").length == 3);
+        STATIC_REQUIRE(run<automaton>("42ll;").length == 4);
+        STATIC_REQUIRE(run<automaton>("42l").length == 2);
+    }
+
+    SECTION("No match.") {
+        STATIC_REQUIRE(run<automaton>("+").length == 0);
+        STATIC_REQUIRE(run<automaton>("").rule == ctle::dfa::no_rule);
+    }
+}
+
+TEST_CASE("Test bounded repetition.", "[ctle::dfa::automaton]") {
+    using automaton = automaton_t<"a{2,3}", "b{2,}">;
+
+    STATIC_REQUIRE(run<automaton>("a").length == 0);
+    STATIC_REQUIRE(run<automaton>("aaaa").length == 3);
+    STATIC_REQUIRE(run<automaton>("bbbbb").length == 5);
+    STATIC_REQUIRE(run<automaton>("bbbbb").rule == 1);
+}
+
+TEST_CASE("Test rules which can't be a part of the automaton.", "[ctle::dfa::automaton]") {
+    using automaton = automaton_t<"/\\*.*?\\*/", "(a)b", "[a-z]+">;
+
+    STATIC_REQUIRE_FALSE(automaton::compiled(0));
+    STATIC_REQUIRE_FALSE(automaton::compiled(1));
+    STATIC_REQUIRE(automaton::compiled(2));
+    STATIC_REQUIRE(run<automaton>("ab").rule == 2);
+}
+
+TEST_CASE("Test rules whose CTRE match isn't the longest.", "[ctle::dfa::automaton]") {
+    using automaton
+      = automaton_t<"[a-z]*+[a-z]", "a|ab", "x?x", "/\\*[^*]*+\\*/", "[0-9]+(?:\\.[0-9]+)?">;
+
+    STATIC_REQUIRE_FALSE(automaton::compiled(0));
+    STATIC_REQUIRE_FALSE(automaton::compiled(1));
+    STATIC_REQUIRE_FALSE(automaton::compiled(2));
+    STATIC_REQUIRE(automaton::compiled(3));
+    STATIC_REQUIRE(automaton::compiled(4));
+    STATIC_REQUIRE(run<automaton>("ab").length == 0);
+    STATIC_REQUIRE(run<automaton>("1.5;").length == 3);
+}
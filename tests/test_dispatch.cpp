@@ -0,0 +1,31 @@
+#include "dispatch.h"
+#include "rule.h"
+
+#include <catch2.h>
+
+template<ctll::fixed_string... Patterns>
+using table_t = ctle::first_byte_table<typename ctle::rule<Patterns>::pattern_t::ast_t...>;
+
+template<typename Table>
+constexpr auto candidates(char byte) {
+    return Table::candidates(Table::byte_class(static_cast<uint8_t>(byte)));
+}
+
+TEST_CASE("Test first byte classes.", "[ctle::first_byte_table]") {
+    using table = table_t<"if", "[a-z_][a-z_0-9]*", "[0-9]+", "(?:0x)?[a-f]+", "/\\*.*?\\*/">;
+
+    SECTION("Bytes are split by rules which can start with them.") {
+        STATIC_REQUIRE(table::byte_class('j') == table::byte_class('z'));
+        STATIC_REQUIRE(table::byte_class('i') != table::byte_class('a'));
+        STATIC_REQUIRE(table::byte_class('0') != table::byte_class('1'));
+        STATIC_REQUIRE(table::byte_class('+') == table::byte_class(' '));
+    }
+
+    SECTION("Candidates.") {
+        STATIC_REQUIRE(candidates<table>('i') == std::array{true, true, false, false, false});
+        STATIC_REQUIRE(candidates<table>('b') == std::array{false, true, false, true, false});
+        STATIC_REQUIRE(candidates<table>('0') == std::array{false, false, true, true, false});
+        STATIC_REQUIRE(candidates<table>('/') == std::array{false, false, false, false, true});
+        STATIC_REQUIRE(candidates<table>(' ') == std::array{false, false, false, false, false});
+    }
+}
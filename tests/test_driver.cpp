@@ -0,0 +1,120 @@
+#include "default_actions.h"
+#include "driver.h"
+#include "lexer.h"
+#include "rule.h"
+
+#include <algorithm>
+#include <catch2.h>
+#include <string>
+#include <vector>
+
+namespace {
+enum class tokens { word = ctle::state_reserved, string, op, eof, no_match };
+enum class states { comment = ctle::state_reserved };
+
+/** @brief switches to a state without returning a token. */
+template<auto State>
+struct switch_to
+{
+    constexpr void operator()(auto& lexer, auto&&...) const {
+        lexer.template set_state<State>();
+    }
+};
+
+using rules = ctll::list<
+  ctle::rule<"[a-z]+", ctle::default_actions::simple_return(tokens::word)>,
+  ctle::rule<"\"[^\"\\n]*\"", ctle::default_actions::simple_return(tokens::string)>,
+  ctle::rule<"<<=|<<|<|=|\\*", ctle::default_actions::simple_return(tokens::op)>,
+  ctle::rule<"[ \\n]+">, ctle::rule<"/\\*", switch_to<states::comment>{}>,
+  ctle::rule<"\\*/", switch_to<ctle::state_initial>{}, std::array{states::comment}>,
+  ctle::rule<"[^*]++|\\*", ctle::empty_callable, std::array{states::comment}>>;
+
+using states_t = ctle::states<states, ctll::list<ctle::state<states::comment, true>>>;
+using lexer_t = ctle::lexer<tokens, rules, states_t>;
+using driver_t = ctle::parallel_driver<lexer_t>;
+
+bool is_last(tokens kind) { return kind == tokens::eof || kind == tokens::no_match; }
+
+/** @brief repeats a text until the result is at least size long. */
+std::string repeat(std::string_view text, size_t size) {
+    std::string retval;
+    while (retval.size() < size) retval += text;
+    return retval;
+}
+
+driver_t::buffer_t lex_serial(std::string_view input) {
+    lexer_t lexer;
+    lexer.set_input(input);
+
+    driver_t::buffer_t retval;
+    do retval.push_back(lexer.lex_compact());
+    while (!is_last(retval.back().kind));
+    return retval;
+}
+
+void require_same(const driver_t::buffer_t& chunked, const driver_t::buffer_t& serial) {
+    REQUIRE(chunked.size() == serial.size());
+    auto differs = std::mismatch(chunked.begin(), chunked.end(), serial.begin(),
+                                 [](const auto& left, const auto& right) {
+                                     return left.kind == right.kind && left.offset == right.offset
+                                            && left.length == right.length;
+                                 });
+    REQUIRE(differs.first == chunked.end());
+}
+} // namespace
+
+TEST_CASE("Test lexing an input in chunks.", "[ctle::parallel_driver::lex_chunked]") {
+    // two chunks, the second begins after the first newline past the middle or at the middle.
+    driver_t           driver{2};
+    driver_t::buffer_t chunked;
+    std::string        input;
+
+    SECTION("A boundary inside a block comment.") {
+        input = repeat("ab cd\n", 60000) + "/*\n";
+        input += repeat("ab \"cd\" <<= ef\n", 80000) + "*/\n";
+        input += repeat("ab \"cd\" <<= ef\n", 140000);
+    }
+
+    SECTION("A boundary inside a string literal.") {
+        input = repeat("ab ", 65000) + "\"";
+        input += repeat("cd <<= * ", 75000 - input.size()) + "\"";
+        input += repeat(" ab \"cd\"", 140000 - input.size());
+        REQUIRE(input.find('\n') == std::string::npos);
+    }
+
+    SECTION("A boundary inside a multi-byte operator.") {
+        // the middle is the second character of a <<=.
+        input = repeat("a<<=", 4 * 32769);
+        REQUIRE(input.substr(input.size() / 2 - 2, 4) == "a<<=");
+    }
+
+    auto statistics = driver.lex_chunked(std::string_view{input}, chunked, is_last);
+    require_same(chunked, lex_serial(input));
+    REQUIRE(statistics.tokens == chunked.size());
+    REQUIRE(chunked.back().kind == tokens::eof);
+}
+
+TEST_CASE("Test lexing many inputs.", "[ctle::parallel_driver::lex]") {
+    // uneven sizes, a few large ones among many small and some empty ones.
+    std::vector<std::string> texts;
+    for (size_t i = 0; i < 300; ++i) {
+        auto size = (i % 37 == 0) ? 200000 : (i % 11 == 0) ? 0 : (i * 131) % 3000;
+        texts.push_back(repeat(i % 2 ? "ab \"cd\" <<= /* ef */ gh\n" : "ab*cd = \"e\" f\n", size));
+    }
+    std::vector<std::string_view> inputs(texts.begin(), texts.end());
+
+    driver_t                        driver{4};
+    std::vector<driver_t::buffer_t> outputs;
+    auto                            statistics = driver.lex(inputs, outputs, is_last);
+
+    REQUIRE(outputs.size() == inputs.size());
+    size_t tokens = 0, bytes = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        require_same(outputs[i], lex_serial(inputs[i]));
+        tokens += outputs[i].size();
+        bytes += inputs[i].size();
+    }
+    REQUIRE(statistics.files == inputs.size());
+    REQUIRE(statistics.tokens == tokens);
+    REQUIRE(statistics.bytes == bytes);
+}
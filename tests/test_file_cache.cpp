@@ -0,0 +1,116 @@
+#include "file_cache.h"
+
+#include <catch2.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace {
+using cache_t = ctle::basic_file_cache<char>;
+
+/** @brief a directory of files of 4000 bytes each. */
+struct directory
+{
+    std::filesystem::path path;
+
+    directory() {
+        char name[] = "/tmp/ctle_cache_XXXXXX";
+        REQUIRE(mkdtemp(name));
+        path = name;
+
+        std::filesystem::create_directory(path / "sub");
+        for (auto name : {"a", "b", "c"}) write(name, std::string(4000, name[0]));
+    }
+
+    ~directory() { std::filesystem::remove_all(path); }
+
+    void write(const char* name, std::string_view content) const {
+        std::ofstream{path / name, std::ios::binary | std::ios::trunc} << content;
+    }
+};
+
+std::string_view view(const cache_t::file_ptr& file) {
+    return std::string_view{file->begin(), file->size()};
+}
+} // namespace
+
+TEST_CASE("Test caching mapped files.", "[ctle::basic_file_cache]") {
+    directory files;
+    cache_t   cache{10000};
+
+    SECTION("A file is mapped once.") {
+        auto file = cache.get(files.path / "a");
+        REQUIRE(file);
+        REQUIRE(view(file) == std::string(4000, 'a'));
+        REQUIRE(cache.get(files.path / "a") == file);
+        REQUIRE(cache.size() == 1);
+        REQUIRE(cache.mapped_bytes() == 4000);
+
+        auto cached = ctle::basic_cached_file<char>::create(cache, files.path / "a");
+        REQUIRE(cached);
+        REQUIRE(cached->begin() == file->begin());
+    }
+
+    SECTION("Paths naming the same file share it.") {
+        auto file = cache.get(files.path / "a");
+        std::filesystem::create_symlink(files.path / "a", files.path / "link");
+
+        REQUIRE(cache.get(files.path / "sub" / ".." / "a") == file);
+        REQUIRE(cache.get(files.path / "link") == file);
+        REQUIRE(cache.size() == 1);
+    }
+
+    SECTION("The least recently used file is dropped beyond the capacity.") {
+        auto a = cache.get(files.path / "a");
+        auto b = cache.get(files.path / "b");
+        REQUIRE(cache.get(files.path / "a") == a);
+        auto c = cache.get(files.path / "c");
+
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.mapped_bytes() == 8000);
+        REQUIRE(cache.get(files.path / "a") == a);
+        // a dropped file stays mapped while in use, it's mapped again.
+        REQUIRE(view(b) == std::string(4000, 'b'));
+        REQUIRE(cache.get(files.path / "b") != b);
+        REQUIRE(cache.size() == 2);
+    }
+
+    SECTION("A file which changed is mapped again.") {
+        auto old = cache.get(files.path / "a");
+        files.write("a", "changed");
+
+        auto file = cache.get(files.path / "a");
+        REQUIRE(file != old);
+        REQUIRE(view(file) == "changed");
+        REQUIRE(cache.size() == 1);
+        REQUIRE(cache.mapped_bytes() == 7);
+    }
+
+    SECTION("A file replaced by another is mapped again, the old one stays valid.") {
+        auto old = cache.get(files.path / "a");
+        files.write("new", "replaced");
+        std::filesystem::rename(files.path / "new", files.path / "a");
+
+        auto file = cache.get(files.path / "a");
+        REQUIRE(view(file) == "replaced");
+        REQUIRE(view(old) == std::string(4000, 'a'));
+        // the old one is dropped once it's the least recently used.
+        REQUIRE(cache.size() == 2);
+    }
+
+    SECTION("A file which can't be opened.") {
+        REQUIRE(!cache.get(files.path / "missing"));
+        REQUIRE(!ctle::basic_cached_file<char>::create(cache, files.path / "missing"));
+        REQUIRE(cache.size() == 0);
+    }
+
+    SECTION("Clearing drops all files.") {
+        auto file = cache.get(files.path / "a");
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+        REQUIRE(cache.mapped_bytes() == 0);
+        REQUIRE(cache.get(files.path / "a") != file);
+    }
+}
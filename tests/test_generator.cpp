@@ -0,0 +1,56 @@
+// generator.h needs coroutines, the compilers the tests are built by otherwise may not have them.
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#include "default_actions.h"
+#include "generator.h"
+#include "lexer.h"
+#include "rule.h"
+
+#include <catch2.h>
+#include <string_view>
+
+namespace {
+enum class tokens { word, eof, no_match };
+
+using rules
+  = ctll::list<ctle::rule<"[a-z]+", ctle::default_actions::simple_return(tokens::word)>,
+               ctle::rule<" ">>;
+using lexer_t = ctle::lexer<tokens, rules>;
+
+bool is_last(tokens kind) { return kind == tokens::eof; }
+} // namespace
+
+TEST_CASE("Test generating tokens.", "[ctle::token_generator]") {
+    lexer_t lexer;
+    lexer.set_input(std::string_view{"ab cd ef"});
+    auto generator = ctle::make_token_generator(lexer, is_last);
+
+    decltype(lexer.lex()) token;
+
+    SECTION("Iterating goes on after the tokens returned by next.") {
+        REQUIRE(generator.next(token));
+        REQUIRE(std::get<1>(token) == "ab");
+
+        auto it = generator.begin();
+        REQUIRE(std::get<1>(*it) == "cd");
+        REQUIRE(std::get<1>(*generator.begin()) == "cd");
+        ++it;
+        REQUIRE(std::get<1>(*it) == "ef");
+        ++it;
+        REQUIRE(std::get<0>(*it) == tokens::eof);
+        ++it;
+        REQUIRE(it == generator.end());
+        REQUIRE(!generator.next(token));
+    }
+
+    SECTION("Next goes on after the tokens iterated over.") {
+        auto it = generator.begin();
+        REQUIRE(std::get<1>(*it) == "ab");
+        ++it;
+        REQUIRE(generator.next(token));
+        REQUIRE(std::get<1>(token) == "cd");
+        REQUIRE(generator.next(token));
+        REQUIRE(std::get<1>(token) == "ef");
+        REQUIRE(std::get<0>(*generator.begin()) == tokens::eof);
+    }
+}
+#endif
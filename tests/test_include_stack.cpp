@@ -0,0 +1,106 @@
+#include "adaptive_file.h"
+#include "default_actions.h"
+#include "include_stack.h"
+#include "lexer.h"
+#include "rule.h"
+
+#include <catch2.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace {
+enum class tokens { word, eof, no_match };
+
+/** @brief the directory the included files are in. */
+std::filesystem::path directory;
+
+/** @brief includes the file named by the lexeme after its @, returns nothing. */
+struct include_file
+{
+    void operator()(auto& lexer, auto lexeme) const {
+        lexer.include(directory / std::string{lexeme.substr(1)});
+    }
+};
+
+using files_t = ctle::include_stack<ctle::basic_adaptive_file<char>>;
+using rules
+  = ctll::list<ctle::rule<"[a-z]+", ctle::default_actions::simple_return(tokens::word)>,
+               ctle::rule<"[ \n]+">, ctle::rule<"@[a-z]+", include_file{}>>;
+using lexer_t
+  = ctle::lexer<tokens, rules, ctle::states<>, ctle::extensions<files_t::template inner>>;
+
+/** @brief writes the files of a test into a new directory. */
+struct files
+{
+    explicit files(std::initializer_list<std::pair<const char*, std::string_view>> contents) {
+        char name[] = "/tmp/ctle_include_XXXXXX";
+        REQUIRE(mkdtemp(name));
+        directory = name;
+
+        for (auto [file, content] : contents)
+            std::ofstream{directory / file, std::ios::binary} << content;
+    }
+
+    ~files() { std::filesystem::remove_all(directory); }
+};
+
+/** @brief requires the next token to be a word at an offset of the file it is in. */
+void require_word(lexer_t& lexer, std::string_view word, uint32_t offset) {
+    auto token = lexer.lex_compact();
+    REQUIRE(token.kind == tokens::word);
+    REQUIRE(token.offset == offset);
+    REQUIRE(token.length == word.size());
+}
+} // namespace
+
+TEST_CASE("Test including files.", "[ctle::include_stack]") {
+    lexer_t lexer;
+
+    SECTION("An included file is lexed in place, the includer goes on after it.") {
+        files written{{"main", "ab @inner cd"}, {"inner", "ef gh"}};
+        REQUIRE(lexer.include(directory / "main"));
+        REQUIRE(lexer.include_depth() == 1);
+
+        REQUIRE(std::get<1>(lexer.lex()) == "ab");
+        REQUIRE(std::get<1>(lexer.lex()) == "ef");
+        REQUIRE(lexer.include_depth() == 2);
+        REQUIRE(std::get<1>(lexer.lex()) == "gh");
+        REQUIRE(std::get<1>(lexer.lex()) == "cd");
+        REQUIRE(lexer.include_depth() == 1);
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::eof);
+    }
+
+    SECTION("Nested includes go back to each includer in turn.") {
+        files written{{"a", "one @b two"}, {"b", "@c three\n@c"}, {"c", "four"}};
+        REQUIRE(lexer.include(directory / "a"));
+
+        for (auto word : {"one", "four", "three", "four", "two"})
+            REQUIRE(std::get<1>(lexer.lex()) == word);
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::eof);
+        REQUIRE(lexer.include_depth() == 0);
+    }
+
+    SECTION("Offsets after an include are of the file which included it.") {
+        files written{{"main", "ab @inner cd @inner\nef"}, {"inner", "  gh"}};
+        REQUIRE(lexer.include(directory / "main"));
+
+        require_word(lexer, "ab", 0);
+        require_word(lexer, "gh", 2);
+        require_word(lexer, "cd", 10);
+        require_word(lexer, "gh", 2);
+        require_word(lexer, "ef", 20);
+        REQUIRE(lexer.lex_compact().kind == tokens::eof);
+    }
+
+    SECTION("An empty file and one which can't be opened.") {
+        files written{{"main", "ab @empty cd @missing ef"}, {"empty", ""}};
+        REQUIRE(!lexer.include(directory / "missing"));
+        REQUIRE(lexer.include(directory / "main"));
+
+        for (auto word : {"ab", "cd", "ef"}) REQUIRE(std::get<1>(lexer.lex()) == word);
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::eof);
+    }
+}
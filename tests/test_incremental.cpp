@@ -0,0 +1,108 @@
+#include "default_actions.h"
+#include "incremental.h"
+#include "lexer.h"
+#include "rule.h"
+
+#include <algorithm>
+#include <catch2.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace {
+enum class tokens { word = ctle::state_reserved, op, comment, eof, no_match };
+enum class states { comment = ctle::state_reserved };
+
+/** @brief switches to a state without returning a token. */
+template<auto State>
+struct switch_to
+{
+    constexpr void operator()(auto& lexer, auto&&...) const {
+        lexer.template set_state<State>();
+    }
+};
+
+using rules = ctll::list<
+  ctle::rule<"[a-z]+", ctle::default_actions::simple_return(tokens::word)>,
+  ctle::rule<"<<=|<<|<|=|\\*|/", ctle::default_actions::simple_return(tokens::op)>,
+  ctle::rule<"[ \\n]+">, ctle::rule<"/\\*", switch_to<states::comment>{}>,
+  ctle::rule<"\\*/", switch_to<ctle::state_initial>{}, std::array{states::comment}>,
+  ctle::rule<"[^*]++|\\*", ctle::default_actions::simple_return(tokens::comment),
+             std::array{states::comment}>>;
+
+using states_t = ctle::states<states, ctll::list<ctle::state<states::comment, true>>>;
+using lexer_t = ctle::lexer<tokens, rules, states_t>;
+
+bool is_last(tokens kind) { return kind == tokens::eof || kind == tokens::no_match; }
+
+using incremental_t = ctle::incremental_lexer<lexer_t, decltype(&is_last)>;
+// <<= decides where < ends two characters after it.
+constexpr size_t lookahead = 2;
+
+/** @brief requires the tokens kept to be those of lexing the whole text. */
+void require_lexed(const incremental_t& incremental, std::string_view text) {
+    incremental_t whole{is_last, lookahead};
+    whole.lex(text);
+
+    REQUIRE(incremental.size() == whole.size());
+    for (size_t i = 0; i < whole.size(); ++i) {
+        auto token = incremental.token(i), expected = whole.token(i);
+        REQUIRE(token.kind == expected.kind);
+        REQUIRE(token.offset == expected.offset);
+        REQUIRE(token.length == expected.length);
+        REQUIRE(incremental.state(i) == whole.state(i));
+    }
+}
+} // namespace
+
+TEST_CASE("Test lexing incrementally.", "[ctle::incremental_lexer]") {
+    std::string   text = "ab <<= cd /* ef gh */ ij << kl\n/* mn */ op";
+    incremental_t incremental{is_last, lookahead};
+    incremental.lex(std::string_view{text});
+
+    auto edit = [&](size_t begin, size_t removed, std::string_view inserted) {
+        text.replace(begin, removed, inserted);
+        incremental.update(std::string_view{text}, begin, removed, inserted.size());
+        require_lexed(incremental, text);
+    };
+
+    SECTION("Edits inside tokens.") {
+        edit(1, 0, "x");
+        edit(text.find("<<=") + 2, 1, "");
+        edit(text.find("<<") + 2, 0, "=");
+        edit(text.find("ij"), 2, "i j");
+    }
+
+    SECTION("Edits inside comments.") {
+        edit(text.find("ef") + 1, 0, "zz");
+        edit(text.find("gh"), 0, "*");
+        edit(text.find("gh") - 1, 0, "/");
+        edit(text.find("mn"), 2, "*/ x /*");
+    }
+
+    SECTION("Edits at state boundaries.") {
+        edit(text.find("/*"), 1, "");
+        edit(text.find("* ef"), 0, "/");
+        edit(text.find("*/"), 2, "");
+        edit(text.find("ij"), 0, "*/");
+        edit(text.find("\n") + 1, 0, "/");
+    }
+
+    SECTION("Random edits.") {
+        constexpr std::string_view alphabet = "ab <=*/\n";
+        uint32_t                   seed = 12345;
+        auto                       random = [&](size_t bound) {
+            seed = seed * 1664525 + 1013904223;
+            return static_cast<size_t>(seed >> 8) % bound;
+        };
+
+        for (int i = 0; i < 200; ++i) {
+            auto        begin = random(text.size() + 1);
+            auto        removed = std::min(random(4), text.size() - begin);
+            std::string inserted;
+            for (auto count = random(4); count--;) inserted += alphabet[random(alphabet.size())];
+
+            edit(begin, removed, inserted);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#include "keywords.h"
+#include "rule.h"
+
+#include <catch2.h>
+
+template<ctll::fixed_string... Patterns>
+using table_t = ctle::keyword_table<typename ctle::rule<Patterns>::pattern_t::ast_t...>;
+
+TEST_CASE("Test keyword lookup.", "[ctle::keyword_table]") {
+    using table = table_t<"if", "int", "\\+", "42", "[a-z_][a-z_0-9]*+", "[0-9]+", "else">;
+
+    SECTION("Literals matched by a class run are absorbed.") {
+        STATIC_REQUIRE(table::absorbed(0));
+        STATIC_REQUIRE(table::absorbed(1));
+        STATIC_REQUIRE_FALSE(table::absorbed(2));
+        STATIC_REQUIRE(table::absorbed(3));
+        STATIC_REQUIRE_FALSE(table::absorbed(4));
+        // can never win against the identifier.
+        STATIC_REQUIRE(table::absorbed(6));
+    }
+
+    SECTION("Keywords are found after their identifier.") {
+        STATIC_REQUIRE(table::has_keywords(4));
+        STATIC_REQUIRE(table::has_keywords(5));
+        STATIC_REQUIRE(table::find<4>("if") == 0);
+        STATIC_REQUIRE(table::find<4>("int") == 1);
+        STATIC_REQUIRE(table::find<5>("42") == 3);
+        STATIC_REQUIRE(table::find<4>("iff") == table::none);
+        STATIC_REQUIRE(table::find<4>("else") == table::none);
+    }
+
+    SECTION("Equal keywords are looked up once, the first wins.") {
+        using duplicates = table_t<"if", "while", "if", "[a-z_][a-z_0-9]*+">;
+        STATIC_REQUIRE(duplicates::absorbed(2));
+        STATIC_REQUIRE(duplicates::find<3>("if") == 0);
+        STATIC_REQUIRE(duplicates::find<3>("while") == 1);
+    }
+}
@@ -0,0 +1,282 @@
+#include "default_actions.h"
+#include "file.h"
+#include "lexer.h"
+#include "rule.h"
+
+#include <algorithm>
+#include <catch2.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+enum class tokens { word = ctle::state_reserved, text, eof, no_match };
+enum states { quoted = ctle::state_reserved };
+
+/** @brief switches to a state without returning a token. */
+template<auto State>
+struct switch_to
+{
+    constexpr void operator()(auto& lexer, auto&&...) const {
+        lexer.set_state(State);
+    }
+};
+
+using rules = ctll::list<
+  ctle::rule<"[a-z]+", ctle::default_actions::simple_return(tokens::word)>, ctle::rule<" ">,
+  ctle::rule<"\"", switch_to<states::quoted>{}>,
+  ctle::rule<"[^\"]+", ctle::default_actions::simple_return(tokens::text),
+             std::array{states::quoted}>,
+  ctle::rule<"\"", switch_to<ctle::state_initial>{}, std::array{states::quoted}>>;
+
+using states_t = ctle::states<states, ctll::list<ctle::state<states::quoted, true>>>;
+using lexer_t = ctle::lexer<tokens, rules, states_t>;
+
+/** @brief counts the words lexed, saved by checkpoints. */
+template<typename LexerT>
+struct counting
+{
+    size_t words{0};
+
+    size_t save_state() const noexcept { return words; }
+
+    void restore_state(size_t words) noexcept { this->words = words; }
+};
+/** @brief an extension which doesn't opt in to checkpoints. */
+template<typename LexerT>
+struct stateless
+{};
+/** @brief returns a word and counts it. */
+struct count_word
+{
+    constexpr tokens operator()(auto& lexer, auto&&...) const {
+        ++lexer.words;
+        return tokens::word;
+    }
+};
+
+/** @brief returns a word and goes on in another input, as an include would. */
+struct jump
+{
+    constexpr tokens operator()(auto& lexer, auto&&...) const {
+        lexer.set_input(std::string_view{"xy"});
+        return tokens::word;
+    }
+};
+
+using jumping_lexer_t = ctle::lexer<
+  tokens, ctll::list<ctle::rule<"[a-z]+", ctle::default_actions::simple_return(tokens::word)>,
+                     ctle::rule<" ">, ctle::rule<"!", jump{}>>>;
+
+using counting_lexer_t
+  = ctle::lexer<tokens, ctll::list<ctle::rule<"[a-z]+", count_word{}>, ctle::rule<" ">>,
+                ctle::states<>, ctle::extensions<counting, stateless>>;
+
+/** @brief an input which records the watermarks it's given. */
+struct releasing_input
+{
+    std::string_view    text;
+    std::vector<size_t> released;
+
+    const char* begin() const noexcept { return text.data(); }
+
+    const char* end() const noexcept { return text.data() + text.size(); }
+
+    void release_before(size_t offset) noexcept { released.push_back(offset); }
+};
+
+/** @brief the resident memory of the process in bytes. */
+size_t resident_bytes() {
+    size_t        pages = 0, resident = 0;
+    std::ifstream{"/proc/self/statm"} >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+} // namespace
+
+TEST_CASE("Test lexing in batches.", "[ctle::lexer::lex_batch]") {
+    std::string_view input = "ab \"cd ef\" gh";
+    lexer_t          lexer;
+    lexer.set_input(input);
+
+    tokens kinds[4];
+    size_t offsets[4], lengths[4];
+
+    SECTION("States switched without a token are lexed on in.") {
+        REQUIRE(lexer.lex_batch({kinds, offsets, lengths, 4}) == 4);
+        REQUIRE(kinds[0] == tokens::word);
+        REQUIRE(kinds[1] == tokens::text);
+        REQUIRE(input.substr(offsets[1], lengths[1]) == "cd ef");
+        REQUIRE(kinds[2] == tokens::word);
+        REQUIRE(offsets[2] == 11);
+        REQUIRE(kinds[3] == tokens::eof);
+    }
+
+    SECTION("Full columns stop the batch.") {
+        REQUIRE(lexer.lex_batch({kinds, offsets, lengths, 2}) == 2);
+        REQUIRE(kinds[1] == tokens::text);
+        REQUIRE(lexer.lex_batch({kinds, offsets, lengths, 2}) == 2);
+        REQUIRE(kinds[0] == tokens::word);
+        REQUIRE(kinds[1] == tokens::eof);
+    }
+}
+
+TEST_CASE("Test lexing compact tokens.", "[ctle::lexer::lex_compact]") {
+    SECTION("Offsets and lengths of the lexemes.") {
+        std::string_view input = "ab \"cd ef\" gh";
+        lexer_t          lexer;
+        lexer.set_input(input);
+
+        auto token = lexer.lex_compact();
+        REQUIRE(token.kind == tokens::word);
+        REQUIRE(token.offset == 0);
+        REQUIRE(token.length == 2);
+        token = lexer.lex_compact();
+        REQUIRE(token.kind == tokens::text);
+        REQUIRE(input.substr(token.offset, token.length) == "cd ef");
+        REQUIRE(lexer.lex_compact().offset == 11);
+
+        token = lexer.lex_compact();
+        REQUIRE(token.kind == tokens::eof);
+        REQUIRE(token.offset == input.size());
+        REQUIRE(token.length == 0);
+    }
+
+    SECTION("An action switching inputs doesn't move the offset of its lexeme.") {
+        jumping_lexer_t lexer;
+        lexer.set_input(std::string_view{"ab cd!"});
+
+        REQUIRE(lexer.lex_compact().offset == 0);
+        REQUIRE(lexer.lex_compact().offset == 3);
+        auto token = lexer.lex_compact();
+        REQUIRE(token.offset == 5);
+        REQUIRE(token.length == 1);
+        // the other input.
+        token = lexer.lex_compact();
+        REQUIRE(token.offset == 0);
+        REQUIRE(token.length == 2);
+
+        lexer.set_input(std::string_view{"ab!"});
+        tokens kinds[2];
+        size_t offsets[2], lengths[2];
+        REQUIRE(lexer.lex_batch({kinds, offsets, lengths, 2}) == 2);
+        REQUIRE(offsets[1] == 2);
+    }
+}
+
+TEST_CASE("Test releasing an input behind a watermark.", "[ctle::lexer::release_before]") {
+    releasing_input input{"ab \"cd ef\" gh"};
+    lexer_t         lexer;
+    lexer.set_input(input);
+
+    tokens kinds[2];
+    size_t offsets[2], lengths[2];
+
+    REQUIRE(lexer.lex_batch({kinds, offsets, lengths, 2}) == 2);
+    REQUIRE(input.released.empty());
+    lexer.release_before(offsets[1]);
+    REQUIRE(input.released == std::vector<size_t>{4});
+    // released by lex as well.
+    REQUIRE(std::get<1>(lexer.lex()) == "gh");
+    lexer.release_before(11);
+    REQUIRE(input.released == std::vector<size_t>{4, 11});
+
+    lexer.set_input(std::string_view{input.text});
+    lexer.release_before(4);
+    REQUIRE(input.released.size() == 2);
+}
+
+TEST_CASE("Test resident memory of a huge file.", "[ctle::lexer::release_before]") {
+    char path[] = "/tmp/ctle_resident_XXXXXX";
+    auto fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+    {
+        constexpr size_t size = size_t{64} << 20;
+        std::string      words;
+        while (words.size() < (size_t{1} << 20)) words += "abcdefghijklmnopqrstuvwxyzabcdef ";
+        std::ofstream file{path, std::ios::binary};
+        for (size_t written = 0; written < size; written += words.size()) file << words;
+    }
+    ctle::basic_file<char> input{path};
+    std::filesystem::remove(path);
+
+    // lexes the whole file, releases all but the last MiB read as it goes if release is set.
+    auto lex_all = [&](bool release) {
+        lexer_t lexer;
+        lexer.set_input(input);
+
+        auto   initial = resident_bytes();
+        size_t peak = 0;
+        for (size_t count = 0;; ++count) {
+            auto token = lexer.lex_compact();
+            if (token.kind == tokens::eof) break;
+            if (count % 4096) continue;
+
+            if (release && token.offset > (size_t{1} << 20))
+                lexer.release_before(token.offset - (size_t{1} << 20));
+            peak = std::max(peak, resident_bytes() - std::min(initial, resident_bytes()));
+        }
+        return peak;
+    };
+    REQUIRE(lex_all(true) < (size_t{8} << 20));
+    // the pages released are read again.
+    REQUIRE(lex_all(false) > (size_t{32} << 20));
+}
+
+TEST_CASE("Test checkpoints.", "[ctle::lexer::checkpoint]") {
+    std::string_view input = "ab \"cd ef\" gh";
+    lexer_t          lexer;
+    lexer.set_input(input);
+
+    SECTION("Restoring after more tokens were lexed lexes them again.") {
+        REQUIRE(std::get<1>(lexer.lex()) == "ab");
+        auto saved = lexer.checkpoint();
+        REQUIRE(std::get<1>(lexer.lex()) == "cd ef");
+        REQUIRE(std::get<1>(lexer.lex()) == "gh");
+
+        lexer.restore(saved);
+        auto token = lexer.lex_compact();
+        REQUIRE(token.kind == tokens::text);
+        REQUIRE(token.offset == 4);
+    }
+
+    SECTION("Restoring after a state change restores the state.") {
+        REQUIRE(std::get<1>(lexer.lex()) == "ab");
+        REQUIRE(std::get<1>(lexer.lex()) == "cd ef");
+        REQUIRE(lexer.get_state() == static_cast<int>(states::quoted));
+        auto saved = lexer.checkpoint();
+        REQUIRE(std::get<1>(lexer.lex()) == "gh");
+        REQUIRE(lexer.get_state() == ctle::state_initial);
+
+        lexer.restore(saved);
+        REQUIRE(lexer.get_state() == static_cast<int>(states::quoted));
+        REQUIRE(std::get<1>(lexer.lex()) == "gh");
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::eof);
+    }
+
+    SECTION("A checkpoint of another input is rejected.") {
+        auto saved = lexer.checkpoint();
+        lexer.set_input(input);
+        REQUIRE_THROWS_AS(lexer.restore(saved), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Test checkpoints of extensions.", "[ctle::lexer::checkpoint]") {
+    counting_lexer_t lexer;
+    lexer.set_input(std::string_view{"ab cd ef"});
+
+    REQUIRE(std::get<1>(lexer.lex()) == "ab");
+    auto saved = lexer.checkpoint();
+    REQUIRE(std::get<1>(lexer.lex()) == "cd");
+    REQUIRE(std::get<1>(lexer.lex()) == "ef");
+    REQUIRE(lexer.words == 3);
+
+    lexer.restore(saved);
+    REQUIRE(lexer.words == 1);
+    REQUIRE(std::get<1>(lexer.lex()) == "cd");
+    REQUIRE(lexer.words == 2);
+}
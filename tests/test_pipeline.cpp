@@ -0,0 +1,142 @@
+#include "default_actions.h"
+#include "lexer.h"
+#include "pipeline.h"
+#include "rule.h"
+
+#include <atomic>
+#include <catch2.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+enum class tokens { word, eof, no_match };
+
+using rules
+  = ctll::list<ctle::rule<"[a-z]+", ctle::default_actions::simple_return(tokens::word)>,
+               ctle::rule<" ">>;
+using lexer_t = ctle::lexer<tokens, rules>;
+
+bool is_last(tokens kind) { return kind == tokens::eof || kind == tokens::no_match; }
+
+/** @brief returns numbered tokens, waits before the one given and throws at the one given. */
+struct scripted_lexer
+{
+    int               count{0};
+    int               wait_at{-1};
+    int               throw_at{-1};
+    std::atomic<bool> go_on{false};
+
+    std::tuple<int, std::string_view> lex() {
+        if (count == wait_at)
+            while (!go_on.load()) std::this_thread::yield();
+        if (count == throw_at) throw std::runtime_error("Lexing failed.");
+        return {count++, std::string_view{}};
+    }
+};
+} // namespace
+
+TEST_CASE("Test passing items through a ring.", "[ctle::spsc_ring]") {
+    SECTION("Items are published in batches or by publish.") {
+        ctle::spsc_ring<int, 8, 4> ring;
+        int                        items[8];
+
+        for (int i = 0; i < 3; ++i) REQUIRE(ring.try_push(int{i}));
+        REQUIRE(ring.try_pop(items, 8) == 0);
+        ring.publish();
+        REQUIRE(ring.try_pop(items, 8) == 3);
+        REQUIRE(items[2] == 2);
+    }
+
+    SECTION("A full ring takes no more until items are popped.") {
+        ctle::spsc_ring<int, 8, 4> ring;
+        int                        items[8];
+
+        for (int i = 0; i < 8; ++i) REQUIRE(ring.try_push(int{i}));
+        REQUIRE(!ring.try_push(8));
+        REQUIRE(ring.try_pop(items, 3) == 3);
+        REQUIRE(ring.try_push(8));
+        ring.publish();
+        REQUIRE(ring.try_pop(items, 8) == 5);
+        REQUIRE(items[0] == 3);
+        REQUIRE(ring.try_pop(items, 8) == 1);
+        REQUIRE(items[0] == 8);
+    }
+
+    SECTION("Items keep their order between threads.") {
+        constexpr int               count = 100000;
+        ctle::spsc_ring<int, 64, 8> ring;
+
+        std::thread producer{[&] {
+            for (int i = 0; i < count; ++i)
+                while (!ring.try_push(int{i})) std::this_thread::yield();
+            ring.publish();
+        }};
+
+        std::vector<int> popped;
+        int              items[16];
+        while (popped.size() < count)
+            popped.insert(popped.end(), items, items + ring.try_pop(items, 16));
+        producer.join();
+
+        for (int i = 0; i < count; ++i) REQUIRE(popped[i] == i);
+    }
+}
+
+TEST_CASE("Test lexing through a pipeline.", "[ctle::token_pipeline]") {
+    SECTION("The tokens are those of lexing, in order.") {
+        std::string input;
+        for (int i = 0; i < 20000; ++i) input += (i % 3 ? "ab " : "cde ");
+
+        lexer_t lexer, serial;
+        lexer.set_input(std::string_view{input});
+        serial.set_input(std::string_view{input});
+        // small enough for the lexing thread to wait for the consumer.
+        ctle::token_pipeline<lexer_t, 64> pipeline{lexer, is_last};
+
+        decltype(lexer.lex()) batch[16];
+        size_t                taken = 0;
+        while (auto count = pipeline.next(batch, 16)) {
+            for (size_t i = 0; i < count; ++i, ++taken) REQUIRE(batch[i] == serial.lex());
+        }
+        REQUIRE(taken == 20001);
+    }
+
+    SECTION("Destroying the pipeline early stops the lexing thread.") {
+        std::string input;
+        for (int i = 0; i < 20000; ++i) input += "ab ";
+
+        lexer_t lexer;
+        lexer.set_input(std::string_view{input});
+        {
+            ctle::token_pipeline<lexer_t, 64> pipeline{lexer, is_last};
+            decltype(lexer.lex())             token;
+            REQUIRE(pipeline.next(token));
+            REQUIRE(std::get<1>(token) == "ab");
+        }
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::word);
+    }
+
+    SECTION("Tokens lexed already are seen while lexing waits, what it throws comes after them.") {
+        scripted_lexer lexer;
+        lexer.wait_at = 3;
+        lexer.throw_at = 5;
+        ctle::token_pipeline<scripted_lexer> pipeline{lexer, [](int) { return false; }};
+
+        std::tuple<int, std::string_view> token;
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(pipeline.next(token));
+            REQUIRE(std::get<0>(token) == i);
+        }
+        lexer.go_on = true;
+
+        REQUIRE(pipeline.next(token));
+        REQUIRE(pipeline.next(token));
+        REQUIRE(std::get<0>(token) == 4);
+        REQUIRE_THROWS_AS(pipeline.next(token), std::runtime_error);
+        REQUIRE(!pipeline.next(token));
+    }
+}
@@ -1,6 +1,7 @@
 #include "rule.h"
 #include "default_actions.h"
 #include "states.h"
+#include "regex_traits.h"
 
 #include <catch2.h>
 
@@ -23,6 +24,17 @@ TEST_CASE("Test relaxed matching.", "[ctle::rule]") {
     }
 }
 
+TEST_CASE("Test recognizing without captures.", "[ctle::rule]") {
+    using rule = ctle::rule<"(a)(b+)">;
+
+    using return_t = decltype(rule::recognize(std::declval<char*>(), std::declval<char*>()));
+    STATIC_REQUIRE(std::tuple_size_v<return_t> == 1);
+
+    std::string_view input = "abbc";
+    REQUIRE(rule::recognize(input.begin(), input.end()).to_view() == "abb");
+    REQUIRE(rule::match(input.begin(), input.end()).get<2>().to_view() == "bb");
+}
+
 TEST_CASE("Test state recognition.", "[ctle::rule]") {
     constexpr auto state = 42;
 
@@ -43,3 +55,15 @@ TEST_CASE("Test state recognition.", "[ctle::rule]") {
         STATIC_REQUIRE(rule::is_valid_in_state(42424242));
     }
 }
+
+template<ctll::fixed_string Pattern>
+constexpr size_t max_length = ctle::max_length_of<
+  typename ctle::rule<Pattern>::pattern_t::ast_t>::value();
+
+TEST_CASE("Test maximal match length.", "[ctle::max_length_of]") {
+    STATIC_REQUIRE(max_length<"while"> == 5);
+    STATIC_REQUIRE(max_length<"<<=|->\\*|\\+"> == 3);
+    STATIC_REQUIRE(max_length<"0x[0-9a-f]{1,4}(?:u|ll)?"> == 8);
+    STATIC_REQUIRE(max_length<"[a-z]+"> == ctle::unbounded_length);
+    STATIC_REQUIRE(max_length<"a(?:b*)?"> == ctle::unbounded_length);
+}
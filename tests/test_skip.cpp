@@ -0,0 +1,66 @@
+#include "rule.h"
+#include "skip.h"
+#include "simd.h"
+
+#include <catch2.h>
+
+#include <string>
+
+TEST_CASE("Test finding bytes.", "[ctle::simd]") {
+    // long enough for both the vector and the scalar loop.
+    std::string input(70, ' ');
+    input[40] = 'x';
+
+    constexpr std::array<uint8_t, 1> space{' '};
+    auto begin = input.data();
+    auto end = begin + input.size();
+
+    REQUIRE(ctle::simd::find_first<false>(begin, end, space) == begin + 40);
+    REQUIRE(ctle::simd::find_first<true>(begin + 40, end, space) == begin + 41);
+    REQUIRE(ctle::simd::find_first<false>(begin + 41, end, space) == end);
+
+    input[68] = '*';
+    input[69] = '/';
+    REQUIRE(ctle::simd::find_text(begin, end, "*/") == begin + 68);
+    REQUIRE(ctle::simd::find_text(begin, end - 1, "*/") == end - 1);
+}
+
+TEST_CASE("Test skip shapes.", "[ctle::skip_shape_of]") {
+    using whitespace = ctle::rule<"(?:[ \t\n\f\v\r]|\\\\\r?\n)+">;
+    using line_comment = ctle::rule<"//[^\r\n]*+">;
+    using block_comment = ctle::rule<"/\\*.*?\\*/">;
+
+    STATIC_REQUIRE(whitespace::skip_shape_t::value);
+    STATIC_REQUIRE(line_comment::skip_shape_t::value);
+    STATIC_REQUIRE(block_comment::skip_shape_t::value);
+    STATIC_REQUIRE(!ctle::rule<"[a-z_][a-z_0-9]*">::skip_shape_t::value);
+
+    auto skipped = [](auto rule, std::string_view input) {
+        auto end = decltype(rule)::skip_shape_t::match(input.data(), input.data() + input.size());
+        REQUIRE(std::string_view(input.data(), end - input.data())
+                == decltype(rule)::match(input.begin(), input.end()).to_view());
+        return static_cast<size_t>(end - input.data());
+    };
+
+    REQUIRE(skipped(whitespace{}, " \t\\\n  \\\r\n x") == 10);
+    REQUIRE(skipped(whitespace{}, "x ") == 0);
+    REQUIRE(skipped(line_comment{}, "// a comment\nx") == 12);
+    REQUIRE(skipped(block_comment{}, "/* a\n * comment */ x */") == 18);
+    REQUIRE(skipped(block_comment{}, "/* unterminated") == 0);
+}
+
+TEST_CASE("Test scanning class runs.", "[ctle::class_scan]") {
+    using identifier = ctle::rule<"[a-zA-Z_][a-zA-Z_0-9]*+">;
+    using digits = ctle::rule<"[0-9]+">;
+
+    std::string input = "an_identifier_longer_than_a_vector_of_32_bytes_1234567890123+";
+    auto        match = [&](auto rule, size_t offset) {
+        auto begin = input.data() + offset;
+        return decltype(rule)::match(begin, input.data() + input.size()).to_view().size();
+    };
+
+    REQUIRE(match(identifier{}, 0) == input.size() - 1);
+    REQUIRE(match(identifier{}, 50) == 0);
+    REQUIRE(match(digits{}, 50) == input.size() - 51);
+    REQUIRE(match(digits{}, 0) == 0);
+}
@@ -0,0 +1,141 @@
+#include "default_actions.h"
+#include "lexer.h"
+#include "rule.h"
+#include "stream_input.h"
+
+#include <catch2.h>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+namespace {
+enum class tokens { word, eof, no_match };
+
+using rules
+  = ctll::list<ctle::rule<"[a-z]+", ctle::default_actions::simple_return(tokens::word)>,
+               ctle::rule<" ">>;
+using lexer_t = ctle::lexer<tokens, rules>;
+
+enum class c_tokens { word, comment, string, slash, eof, no_match };
+
+using c_rules = ctll::list<
+  ctle::rule<"[a-z]+", ctle::default_actions::simple_return(c_tokens::word)>,
+  ctle::rule<"/\\*[^*]*+\\*/", ctle::default_actions::simple_return(c_tokens::comment)>,
+  ctle::rule<"\"[^\"]*+\"", ctle::default_actions::simple_return(c_tokens::string)>,
+  ctle::rule<"/", ctle::default_actions::simple_return(c_tokens::slash)>, ctle::rule<" ">>;
+using c_lexer_t = ctle::lexer<c_tokens, c_rules>;
+
+void write_all(int fd, std::string_view text) {
+    REQUIRE(write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size()));
+}
+} // namespace
+
+TEST_CASE("Test lexing a streamed input.", "[ctle::basic_stream_input]") {
+    int ends[2];
+    REQUIRE(pipe(ends) == 0);
+    lexer_t lexer;
+
+    SECTION("A token straddling a refill is lexed whole, offsets are from the stream.") {
+        write_all(ends[1], "ab cdefghij");
+        close(ends[1]);
+        ctle::basic_stream_input<char> input{ends[0], 8};
+        lexer.set_input(input);
+
+        REQUIRE(std::get<1>(lexer.lex()) == "ab");
+        auto token = lexer.lex_compact();
+        REQUIRE(token.kind == tokens::word);
+        REQUIRE(token.offset == 3);
+        REQUIRE(token.length == 8);
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::eof);
+        REQUIRE(input.status() == ctle::stream_status::end);
+    }
+
+    SECTION("A checkpoint before a refill dropping what was lexed is rejected.") {
+        write_all(ends[1], "ab cdefghij");
+        close(ends[1]);
+        ctle::basic_stream_input<char> input{ends[0], 8};
+        lexer.set_input(input);
+
+        auto saved = lexer.checkpoint();
+        REQUIRE(std::get<1>(lexer.lex()) == "ab");
+        lexer.restore(saved);
+        REQUIRE(std::get<1>(lexer.lex()) == "ab");
+        REQUIRE(std::get<1>(lexer.lex()) == "cdefghij");
+        REQUIRE_THROWS_AS(lexer.restore(saved), std::invalid_argument);
+    }
+
+    SECTION("What a pipe has is lexed before it's closed, lexing goes on with what comes later.") {
+        write_all(ends[1], "ab cd ");
+        REQUIRE(fcntl(ends[0], F_SETFL, O_NONBLOCK) == 0);
+        ctle::basic_stream_input<char> input{ends[0], 64};
+        lexer.set_input(input);
+
+        REQUIRE(std::get<1>(lexer.lex()) == "ab");
+        REQUIRE(std::get<1>(lexer.lex()) == "cd");
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::eof);
+        REQUIRE(input.pending());
+
+        write_all(ends[1], "ef");
+        close(ends[1]);
+        REQUIRE(std::get<1>(lexer.lex()) == "ef");
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::eof);
+        REQUIRE(input.exhausted());
+    }
+
+    close(ends[0]);
+}
+
+TEST_CASE("Test lexing tokens split across writes.", "[ctle::basic_stream_input]") {
+    int ends[2];
+    REQUIRE(pipe(ends) == 0);
+    // the comment and the string are unfinished at the end of what was written so far.
+    std::thread writer{[&] {
+        for (std::string_view piece : {"ab /* cd", " ef */ \"gh", " ij\" kl"}) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+            (void)!write(ends[1], piece.data(), piece.size());
+        }
+        close(ends[1]);
+    }};
+
+    ctle::basic_stream_input<char> input{ends[0], 64};
+    c_lexer_t                      lexer;
+    lexer.set_input(input);
+
+    auto token = lexer.lex();
+    REQUIRE(std::get<1>(token) == "ab");
+    token = lexer.lex();
+    REQUIRE(std::get<0>(token) == c_tokens::comment);
+    REQUIRE(std::get<1>(token) == "/* cd ef */");
+    token = lexer.lex();
+    REQUIRE(std::get<0>(token) == c_tokens::string);
+    REQUIRE(std::get<1>(token) == "\"gh ij\"");
+    REQUIRE(std::get<1>(lexer.lex()) == "kl");
+    REQUIRE(std::get<0>(lexer.lex()) == c_tokens::eof);
+
+    writer.join();
+    close(ends[0]);
+}
+
+TEST_CASE("Test lexing a growing file.", "[ctle::basic_stream_input]") {
+    char path[] = "/tmp/ctle_stream_XXXXXX";
+    auto fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    write_all(fd, "ab");
+    {
+        ctle::basic_stream_input<char> input{std::filesystem::path{path}, 16};
+        lexer_t                        lexer;
+        lexer.set_input(input);
+
+        REQUIRE(std::get<1>(lexer.lex()) == "ab");
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::eof);
+        REQUIRE(input.status() == ctle::stream_status::end);
+
+        write_all(fd, " cd");
+        REQUIRE(std::get<1>(lexer.lex()) == "cd");
+        REQUIRE(std::get<0>(lexer.lex()) == tokens::eof);
+    }
+    close(fd);
+    unlink(path);
+}
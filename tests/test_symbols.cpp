@@ -0,0 +1,78 @@
+#include "default_actions.h"
+#include "interning.h"
+#include "lexer.h"
+#include "rule.h"
+#include "symbol_table.h"
+
+#include <catch2.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+enum class tokens { keyword, identifier, eof, no_match };
+
+/** @brief keeps the symbols interned and the hashes the lexer gave their lexemes. */
+template<typename LexerT>
+struct recording
+{
+    std::vector<ctle::symbol_id> interned;
+    std::vector<uint64_t>        hashes;
+};
+/** @brief interns an identifier. */
+struct intern_identifier
+{
+    tokens operator()(auto& lexer, auto lexeme) const {
+        lexer.interned.push_back(lexer.intern(lexeme));
+        lexer.hashes.push_back(lexer.lexeme_hash(lexeme));
+        // a part of the lexeme isn't given the hash of the whole.
+        REQUIRE(lexer.lexeme_hash(lexeme.substr(1)) == ctle::hash_lexeme(lexeme.substr(1)));
+        return tokens::identifier;
+    }
+};
+
+using rules = ctll::list<ctle::rule<"if", ctle::default_actions::simple_return(tokens::keyword)>,
+                         ctle::rule<"[a-z]++", intern_identifier{}>, ctle::rule<" ">>;
+using lexer_t = ctle::lexer<tokens, rules, ctle::states<>,
+                            ctle::extensions<recording, ctle::interning<>::template inner>>;
+} // namespace
+
+TEST_CASE("Test interning symbols.", "[ctle::symbol_table]") {
+    // small enough to grow and to use more blocks.
+    ctle::symbol_table symbols{2, 8};
+
+    SECTION("Equal texts get the same symbol.") {
+        auto first = symbols.intern("main");
+        auto second = symbols.intern("argc");
+        REQUIRE(first != second);
+        REQUIRE(symbols.intern(std::string{"main"}) == first);
+        REQUIRE(symbols.find("argc") == second);
+        REQUIRE(symbols.find("argv") == ctle::symbol_table::none);
+    }
+
+    SECTION("Texts and hashes outlive growing.") {
+        std::string long_text(20, 'x');
+        auto        symbol = symbols.intern(long_text);
+        for (int i = 0; i < 100; ++i) symbols.intern("id" + std::to_string(i));
+
+        REQUIRE(symbols.size() == 101);
+        REQUIRE(symbols.text(symbol) == long_text);
+        REQUIRE(symbols.hash(symbol) == ctle::hash_lexeme(std::string_view{long_text}));
+        REQUIRE(symbols.text(symbols.find("id42")) == "id42");
+        REQUIRE(symbols.intern("id99") == 100);
+    }
+}
+
+TEST_CASE("Test interning identifiers while lexing.", "[ctle::interning]") {
+    lexer_t lexer;
+    lexer.set_input(std::string_view{"ab if abc ab ifs"});
+    while (std::get<0>(lexer.lex()) != tokens::eof) {}
+
+    std::vector<std::string_view> identifiers{"ab", "abc", "ab", "ifs"};
+    REQUIRE(lexer.interned == std::vector<ctle::symbol_id>{0, 1, 0, 2});
+    for (size_t i = 0; i < identifiers.size(); ++i) {
+        REQUIRE(lexer.hashes[i] == ctle::hash_lexeme(identifiers[i]));
+        REQUIRE(lexer.symbols().hash(lexer.interned[i]) == lexer.hashes[i]);
+        REQUIRE(lexer.symbols().text(lexer.interned[i]) == identifiers[i]);
+    }
+}